@@ -44,6 +44,19 @@ class A_Star : public cb::NCursesGameEngine {
 
     int nMapHeight = 0;
 
+    bool bMapChanged = true;
+
+    bool bPathChanged = true;
+
+    // what a drag makes the cells it passes
+    bool bDragValid = false;
+
+    // the cells of the last presses, most recent first, and what they were
+    // before, as the presses of a double or triple click do not toggle them
+    sNode *pPressed[ 3 ] = { nullptr, nullptr, nullptr };
+
+    bool bPressedValid[ 3 ] = { true, true, true };
+
     bool OnUserCreate() override {
 
         nMapHeight = ( ScreenHeight() / nCellSize );
@@ -67,7 +80,7 @@ class A_Star : public cb::NCursesGameEngine {
             }
         }
 
-        srand( time( nullptr ) );
+        srand( RandomSeed() );
 
         p0 = &nodes[ ( ( rand() % nMapWidth ) + ( rand() % nMapHeight ) * nMapWidth ) ];
 
@@ -145,30 +158,90 @@ class A_Star : public cb::NCursesGameEngine {
                 }
             }
         }
+
+        bPathChanged = true;
     }
 
+    // a press toggles a wall and a drag from there makes the cells it passes
+    // the same; every event of the frame counts, not only the last one
     void Input() {
 
-        int nMouseX, nMouseY;
+        cb::InputEvent event;
 
-        if( MousePressed( BUTTON1_CLICKED, nMouseX, nMouseY ) ) {
-            nodes[ ( nMouseX / nCellSize ) + ( nMouseY / nCellSize ) * nMapWidth ].bValid = !nodes[ ( nMouseX / nCellSize ) + ( nMouseY / nCellSize ) * nMapWidth ].bValid;
-            Solve();
-        }
+        bool bSolve = false;
+
+        while( PollEvent( event ) ) {
+
+            if( EVENT_MOUSE != event.nType || event.x >= nMapWidth * nCellSize || event.y >= nMapHeight * nCellSize ) continue;
+
+            sNode *node = &nodes[ ( event.x / nCellSize ) + ( event.y / nCellSize ) * nMapWidth ];
+
+            if( event.nButtons & BUTTON1_PRESSED ) {
+
+                if( !( event.nButtons & REPORT_MOUSE_POSITION ) ) {
 
-        if( MousePressed( BUTTON1_DOUBLE_CLICKED, nMouseX, nMouseY ) ) {
-            p0 = &nodes[ ( nMouseX / nCellSize ) + ( nMouseY / nCellSize ) * nMapWidth ];
-            Solve();
+                    bDragValid = !node->bValid;
+
+                    for( int i = 2; i > 0; i-- ) {
+                        pPressed[ i ] = pPressed[ i - 1 ];
+                        bPressedValid[ i ] = bPressedValid[ i - 1 ];
+                    }
+
+                    pPressed[ 0 ] = node;
+                    bPressedValid[ 0 ] = node->bValid;
+                }
+
+                if( node->bValid != bDragValid ) {
+                    node->bValid = bDragValid;
+                    bMapChanged = true;
+                    bSolve = true;
+                }
+            }
+
+            if( event.nButtons & ( BUTTON1_DOUBLE_CLICKED | BUTTON1_TRIPLE_CLICKED ) ) UndoPresses( event.nButtons & BUTTON1_DOUBLE_CLICKED ? 2 : 3 );
+
+            if( event.nButtons & BUTTON1_DOUBLE_CLICKED ) {
+                p0 = node;
+                bSolve = true;
+            }
+
+            if( event.nButtons & BUTTON1_TRIPLE_CLICKED ) {
+                p1 = node;
+                bSolve = true;
+            }
         }
 
-        if( MousePressed( BUTTON1_TRIPLE_CLICKED, nMouseX, nMouseY ) ) {
-            p1 = &nodes[ ( nMouseX / nCellSize ) + ( nMouseY / nCellSize ) * nMapWidth ];
-            Solve();
+        if( bSolve ) Solve();
+    }
+
+    // puts back the cells of the last nPresses presses, the oldest last
+    void UndoPresses( int nPresses ) {
+
+        for( int i = 0; i < nPresses; i++ ) {
+
+            if( nullptr == pPressed[ i ] ) continue;
+
+            pPressed[ i ]->bValid = bPressedValid[ i ];
+
+            pPressed[ i ] = nullptr;
         }
+
+        bMapChanged = true;
     }
 
+    // the map only changes with a click and the path only when solved, both
+    // stay on their layers in between
     void Draw() {
 
+        if( bMapChanged ) DrawMap();
+
+        if( bPathChanged ) DrawPath();
+    }
+
+    void DrawMap() {
+
+        SetLayer( LAYER_BACKGROUND );
+
         Clear( PIXEL_FULL, FG_TEAL );
 
         for( int i = 0; i < nMapWidth * nMapHeight; i++ ) {
@@ -190,6 +263,15 @@ class A_Star : public cb::NCursesGameEngine {
             DrawRectangle( nCellSize * nodes[ i ].x + nCellPadding, nCellSize * nodes[ i ].y + nCellPadding, nCellSize * nodes[ i ].x + nCellSize - nCellPadding, nCellSize * nodes[ i ].y + nCellSize - nCellPadding, PIXEL_FULL, color );
         }
 
+        bMapChanged = false;
+    }
+
+    void DrawPath() {
+
+        SetLayer( LAYER_WORLD );
+
+        Clear( PIXEL_TRANSPARENT );
+
         sNode *n = p1;
 
         while( n->parent != nullptr ) {
@@ -211,9 +293,19 @@ class A_Star : public cb::NCursesGameEngine {
         DrawRectangle( nCellSize * p0->x + nCellPadding, nCellSize * p0->y + nCellPadding, nCellSize * p0->x + nCellSize - nCellPadding, nCellSize * p0->y + nCellSize - nCellPadding, PIXEL_FULL, FG_RED );
 
         DrawRectangle( nCellSize * p1->x + nCellPadding, nCellSize * p1->y + nCellPadding, nCellSize * p1->x + nCellSize - nCellPadding, nCellSize * p1->y + nCellSize - nCellPadding, PIXEL_FULL, FG_GREEN );
+
+        bPathChanged = false;
     }
 
-    bool OnUserResize() override { return true; }
+    // the layers are cleared on a resize
+    bool OnUserResize() override {
+
+        bMapChanged = true;
+
+        bPathChanged = true;
+
+        return true;
+    }
 };
 
 #endif // CBNCURSESGAMEENGINE__A_STAR_H
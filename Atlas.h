@@ -0,0 +1,408 @@
+/**
+ *  @file   Atlas.h
+ *  @brief  Sprite atlases for the NCursesGameEngine
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_ATLAS_H
+#define CBNCURSESGAMEENGINE_ATLAS_H
+
+#include "Sprite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// An atlas starts with a header of the magic "NCGA" and the version, both
+// uint32_t, followed by the sheet as a sprite is written. Then come the
+// uint32_t number of rects and each rect as its name, and its int32_t x, y,
+// width and height on the sheet, and the uint32_t number of animations and
+// each animation as its name, its time per frame as a float, the uint32_t
+// number of frames and the uint32_t index of the rect of every frame. A name
+// is stored as its uint32_t length and its characters.
+
+namespace cb {
+class Atlas;
+enum [[maybe_unused]] atlases : uint32_t{ATLAS_MAGIC = 0x4147434e,
+                                         ATLAS_VERSION = 1};
+}; // namespace cb
+
+// Keeps many sprites as rects on a single sheet, found by their name, and
+// animations as sequences of those rects. Rects are looked up by name once,
+// into an index that is used while drawing.
+class cb::Atlas {
+
+public:
+  typedef struct {
+    int x;
+    int y;
+    int nWidth;
+    int nHeight;
+  } Rect;
+
+  // packs the sprites onto a new sheet, in shelves of rows from the highest
+  // sprite down, with the space left over transparent
+  [[maybe_unused]] bool
+  Pack(const std::vector<std::pair<std::string, const cb::Sprite *>> &vSprites) {
+
+    Clear();
+
+    int nArea = 0, nSheetWidth = 1;
+
+    for (const auto &sprite : vSprites) {
+
+      if (sprite.second->SpriteWidth() * sprite.second->SpriteHeight() <= 0 ||
+          !AddName(mRects, vRectNames, sprite.first, Rects()))
+        return Clear();
+
+      vRects.push_back({0, 0, sprite.second->SpriteWidth(),
+                        sprite.second->SpriteHeight()});
+
+      nArea += sprite.second->SpriteWidth() * sprite.second->SpriteHeight();
+
+      nSheetWidth = std::max(nSheetWidth, sprite.second->SpriteWidth());
+    }
+
+    // about square
+    nSheetWidth = std::max(nSheetWidth,
+                           static_cast<int>(std::ceil(std::sqrt(nArea))));
+
+    std::vector<int> vOrder(vRects.size());
+
+    for (int i = 0; i < static_cast<int>(vOrder.size()); i++)
+      vOrder[i] = i;
+
+    std::stable_sort(vOrder.begin(), vOrder.end(), [&](int a, int b) {
+      return vRects[a].nHeight > vRects[b].nHeight;
+    });
+
+    int x = 0, y = 0, nShelfHeight = 0;
+
+    for (int i : vOrder) {
+
+      Rect &rect = vRects[i];
+
+      if (x + rect.nWidth > nSheetWidth) {
+
+        x = 0;
+
+        y += nShelfHeight;
+
+        nShelfHeight = 0;
+      }
+
+      rect.x = x;
+
+      rect.y = y;
+
+      x += rect.nWidth;
+
+      nShelfHeight = std::max(nShelfHeight, rect.nHeight);
+    }
+
+    if (!sprSheet.Create(nSheetWidth, std::max(1, y + nShelfHeight)))
+      return Clear();
+
+    for (int i = 0; i < nSheetWidth * sprSheet.SpriteHeight(); i++)
+      sprSheet[i] = {cb::Sprite::cTransparent, 0, 0};
+
+    for (int i = 0; i < static_cast<int>(vRects.size()); i++) {
+
+      const Rect &rect = vRects[i];
+
+      const cb::Pixel *pPixels = vSprites[i].second->Pixels();
+
+      for (int sy = 0; sy < rect.nHeight; sy++)
+        for (int sx = 0; sx < rect.nWidth; sx++)
+          sprSheet[rect.x + sx + (rect.y + sy) * nSheetWidth] =
+              pPixels[sx + sy * rect.nWidth];
+    }
+
+    return true;
+  }
+
+  // frames are indices of rects, each shown for fFrameTime seconds
+  [[maybe_unused]] int AddAnimation(const std::string &name,
+                                    const std::vector<int> &vFrames,
+                                    float fFrameTime) {
+
+    if (vFrames.empty())
+      return -1;
+
+    for (int nFrame : vFrames)
+      if (nFrame < 0 || nFrame >= Rects())
+        return -1;
+
+    if (!AddName(mAnimations, vAnimationNames, name, Animations()))
+      return -1;
+
+    vAnimations.push_back({fFrameTime, vFrames});
+
+    return Animations() - 1;
+  }
+
+  // the sheet and its index come from a single file, read in one pass
+  [[maybe_unused]] bool Read(const std::filesystem::path &filename) {
+
+    Clear();
+
+    std::ifstream ifstr(filename, std::ios::in | std::ios::binary);
+
+    if (ifstr.fail())
+      return false;
+
+    uint32_t nHeader[2];
+
+    ifstr.read(reinterpret_cast<char *>(nHeader), sizeof(nHeader));
+
+    if (ifstr.fail() || ATLAS_MAGIC != nHeader[0] ||
+        ATLAS_VERSION != nHeader[1] || !sprSheet.Read(ifstr))
+      return Clear();
+
+    uint32_t nRects = 0;
+
+    ifstr.read(reinterpret_cast<char *>(&nRects), sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < nRects && !ifstr.fail(); i++) {
+
+      std::string name;
+
+      int32_t nRect[4];
+
+      if (!ReadName(ifstr, name))
+        return Clear();
+
+      ifstr.read(reinterpret_cast<char *>(nRect), sizeof(nRect));
+
+      if (ifstr.fail() || nRect[0] < 0 || nRect[1] < 0 || nRect[2] <= 0 ||
+          nRect[3] <= 0 || nRect[2] > sprSheet.SpriteWidth() - nRect[0] ||
+          nRect[3] > sprSheet.SpriteHeight() - nRect[1] ||
+          !AddName(mRects, vRectNames, name, Rects()))
+        return Clear();
+
+      vRects.push_back({nRect[0], nRect[1], nRect[2], nRect[3]});
+    }
+
+    uint32_t nAnimations = 0;
+
+    ifstr.read(reinterpret_cast<char *>(&nAnimations), sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < nAnimations && !ifstr.fail(); i++) {
+
+      std::string name;
+
+      float fFrameTime;
+
+      uint32_t nFrames;
+
+      if (!ReadName(ifstr, name))
+        return Clear();
+
+      ifstr.read(reinterpret_cast<char *>(&fFrameTime), sizeof(float));
+
+      ifstr.read(reinterpret_cast<char *>(&nFrames), sizeof(uint32_t));
+
+      // frames may show a rect more than once, but no animation is that
+      // long; the file is broken
+      if (ifstr.fail() || nFrames > 65536)
+        return Clear();
+
+      std::vector<uint32_t> vFrames(nFrames);
+
+      ifstr.read(reinterpret_cast<char *>(vFrames.data()),
+                 nFrames * sizeof(uint32_t));
+
+      if (ifstr.fail() ||
+          -1 == AddAnimation(name, {vFrames.begin(), vFrames.end()},
+                             fFrameTime))
+        return Clear();
+    }
+
+    if (ifstr.fail())
+      return Clear();
+
+    return true;
+  }
+
+  [[maybe_unused]] bool Write(const std::filesystem::path &filename) {
+
+    std::ofstream ofstr(filename, std::ios::binary);
+
+    if (ofstr.fail())
+      return false;
+
+    uint32_t nHeader[2] = {ATLAS_MAGIC, ATLAS_VERSION};
+
+    ofstr.write(reinterpret_cast<char *>(nHeader), sizeof(nHeader));
+
+    if (!sprSheet.Write(ofstr))
+      return false;
+
+    auto nRects = static_cast<uint32_t>(vRects.size());
+
+    ofstr.write(reinterpret_cast<char *>(&nRects), sizeof(uint32_t));
+
+    for (int i = 0; i < Rects(); i++) {
+
+      int32_t nRect[4] = {vRects[i].x, vRects[i].y, vRects[i].nWidth,
+                          vRects[i].nHeight};
+
+      WriteName(ofstr, vRectNames[i]);
+
+      ofstr.write(reinterpret_cast<char *>(nRect), sizeof(nRect));
+    }
+
+    auto nAnimations = static_cast<uint32_t>(vAnimations.size());
+
+    ofstr.write(reinterpret_cast<char *>(&nAnimations), sizeof(uint32_t));
+
+    for (int i = 0; i < Animations(); i++) {
+
+      const Animation &animation = vAnimations[i];
+
+      auto nFrames = static_cast<uint32_t>(animation.vFrames.size());
+
+      std::vector<uint32_t> vFrames(animation.vFrames.begin(),
+                                    animation.vFrames.end());
+
+      WriteName(ofstr, vAnimationNames[i]);
+
+      ofstr.write(reinterpret_cast<const char *>(&animation.fFrameTime),
+                  sizeof(float));
+
+      ofstr.write(reinterpret_cast<char *>(&nFrames), sizeof(uint32_t));
+
+      ofstr.write(reinterpret_cast<char *>(vFrames.data()),
+                  nFrames * sizeof(uint32_t));
+    }
+
+    return !ofstr.fail();
+  }
+
+  // the index of the rect, or -1 when there is none of that name
+  [[maybe_unused]] [[nodiscard]] int Find(const std::string &name) const {
+
+    auto it = mRects.find(name);
+
+    return mRects.end() == it ? -1 : it->second;
+  }
+
+  [[maybe_unused]] [[nodiscard]] int
+  FindAnimation(const std::string &name) const {
+
+    auto it = mAnimations.find(name);
+
+    return mAnimations.end() == it ? -1 : it->second;
+  }
+
+  // the index of the rect of the animation shown at fTime seconds after it
+  // started, looping
+  [[maybe_unused]] [[nodiscard]] int Frame(int nAnimation, float fTime) const {
+
+    const Animation &animation = vAnimations[nAnimation];
+
+    auto nFrames = static_cast<float>(animation.vFrames.size());
+
+    float fFrame = std::fmod(fTime / animation.fFrameTime, nFrames);
+
+    if (fFrame < 0.0f)
+      fFrame += nFrames;
+
+    // also when the time per frame is zero
+    if (!(fFrame >= 0.0f && fFrame < nFrames))
+      fFrame = 0.0f;
+
+    return animation.vFrames[static_cast<int>(fFrame)];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const Rect &RectAt(int nRect) const {
+    return vRects[nRect];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int Rects() const {
+    return static_cast<int>(vRects.size());
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int Animations() const {
+    return static_cast<int>(vAnimations.size());
+  }
+
+  [[maybe_unused]] inline cb::Sprite &Sheet() { return sprSheet; }
+
+private:
+  typedef struct {
+    float fFrameTime;
+    std::vector<int> vFrames;
+  } Animation;
+
+  cb::Sprite sprSheet;
+  std::vector<Rect> vRects;
+  std::vector<std::string> vRectNames;
+  std::unordered_map<std::string, int> mRects;
+  std::vector<Animation> vAnimations;
+  std::vector<std::string> vAnimationNames;
+  std::unordered_map<std::string, int> mAnimations;
+
+  // keeps the sheet, but it is overwritten by the next Pack() or Read()
+  bool Clear() {
+
+    vRects.clear();
+    vRectNames.clear();
+    mRects.clear();
+    vAnimations.clear();
+    vAnimationNames.clear();
+    mAnimations.clear();
+
+    return false;
+  }
+
+  // names are unique
+  static bool AddName(std::unordered_map<std::string, int> &mNames,
+                      std::vector<std::string> &vNames,
+                      const std::string &name, int nIndex) {
+
+    if (!mNames.emplace(name, nIndex).second)
+      return false;
+
+    vNames.push_back(name);
+
+    return true;
+  }
+
+  static bool ReadName(std::istream &in, std::string &name) {
+
+    uint32_t nLength = 0;
+
+    in.read(reinterpret_cast<char *>(&nLength), sizeof(uint32_t));
+
+    // no name is that long; the file is broken
+    if (in.fail() || nLength > 4096)
+      return false;
+
+    name.resize(nLength);
+
+    in.read(name.data(), nLength);
+
+    return !in.fail();
+  }
+
+  static void WriteName(std::ostream &out, const std::string &name) {
+
+    auto nLength = static_cast<uint32_t>(name.size());
+
+    out.write(reinterpret_cast<char *>(&nLength), sizeof(uint32_t));
+
+    out.write(name.data(), nLength);
+  }
+};
+
+#endif // CBNCURSESGAMEENGINE_ATLAS_H
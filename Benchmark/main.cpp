@@ -0,0 +1,232 @@
+/**
+ *  @file   main.cpp
+ *  @brief  Benchmark of the NCursesGameEngine projects
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "../A*/A_Star.h"
+#include "../GFXEngine/GFXEngine.h"
+#include "../GrandPrix/GrandPrix.h"
+#include "../PathFinding/PathFinding.h"
+#include "../SpriteEditor/SpriteEditor.h"
+#include "../Tetris/Tetris.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> nAllocations{0};
+
+// counts every allocation, also of over-aligned types such as the cells of
+// the engine, as the nothrow and array forms end up here; kept out of line,
+// as GCC otherwise warns about free() after the new it inlined
+[[gnu::noinline]] void *operator new(size_t nSize) {
+
+  nAllocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (void *p = malloc(nSize ? nSize : 1))
+    return p;
+
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void *operator new(size_t nSize, std::align_val_t nAlign) {
+
+  nAllocations.fetch_add(1, std::memory_order_relaxed);
+
+  auto nAlignment = static_cast<size_t>(nAlign);
+
+  // aligned_alloc wants a multiple of the alignment
+  size_t nRounded = (std::max<size_t>(nSize, 1) + nAlignment - 1) &
+                    ~(nAlignment - 1);
+
+  if (void *p = aligned_alloc(nAlignment, nRounded))
+    return p;
+
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept { free(p); }
+
+[[gnu::noinline]] void operator delete(void *p, size_t) noexcept { free(p); }
+
+[[gnu::noinline]] void operator delete(void *p, std::align_val_t) noexcept {
+  free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, size_t,
+                                       std::align_val_t) noexcept {
+  free(p);
+}
+
+static constexpr unsigned nSeed = 1;
+
+// the engine keeps its statistics over the last 256 frames
+static constexpr size_t nFrames = 256;
+
+static constexpr int nSizes[][2] = {{120, 40}, {160, 48}, {320, 96}};
+
+static bool bFirstResult = true;
+
+typedef struct {
+  size_t nFrames;
+  size_t nAllocations;
+  cb::MetricSummary sUpdate;
+  cb::MetricSummary sPresent;
+  cb::MetricSummary sBytes;
+  cb::MetricSummary sBytesSaved;
+} Measurement;
+
+void Script(cb::NCursesGameEngine &, size_t, int, int) {}
+
+void Script(Tetris &t, size_t nFrameCount, int, int) {
+
+  const uint16_t nKeys[] = {kVK_LeftArrow, kVK_Space, kVK_RightArrow,
+                            kVK_DownArrow};
+
+  for (size_t n = 0; n < nFrameCount; n += 8) {
+
+    uint16_t nKey = nKeys[(n / 8) % 4];
+
+    t.ScriptKey(n, nKey, true);
+
+    t.ScriptKey(n + 1, nKey, false);
+  }
+}
+
+void Script(GrandPrix &gp, size_t nFrameCount, int, int) {
+
+  gp.ScriptKey(0, kVK_UpArrow, true);
+
+  for (size_t n = 0; n < nFrameCount; n += 64) {
+
+    uint16_t nKey = (n / 64) % 2 ? kVK_RightArrow : kVK_LeftArrow;
+
+    gp.ScriptKey(n, nKey, true);
+
+    gp.ScriptKey(n + 32, nKey, false);
+  }
+}
+
+// clicks stay on the map of games that divide the screen in cells; a press
+// is followed by its release and click the next frame
+void ScriptClicks(cb::NCursesGameEngine &game, size_t nFrameCount, int nWidth,
+                  int nHeight) {
+
+  for (size_t n = 0; n < nFrameCount; n += 16) {
+
+    int x = static_cast<int>(n * 7) % nWidth;
+
+    int y = static_cast<int>(n * 3) % nHeight;
+
+    game.ScriptMouse(n, BUTTON1_PRESSED, x, y);
+
+    game.ScriptMouse(n + 1, BUTTON1_RELEASED | BUTTON1_CLICKED, x, y);
+  }
+}
+
+void Script(A_Star &a, size_t nFrameCount, int nWidth, int nHeight) {
+  ScriptClicks(a, nFrameCount, nWidth / 10 * 10, nHeight / 10 * 10);
+}
+
+void Script(PathFinding &pf, size_t nFrameCount, int nWidth, int nHeight) {
+  ScriptClicks(pf, nFrameCount, nWidth / 3 * 3, nHeight / 3 * 3);
+}
+
+void Script(SpriteEditor &se, size_t nFrameCount, int, int) {
+  ScriptClicks(se, nFrameCount, 41, 41);
+}
+
+template <typename Game, typename... Args>
+Measurement Measure(int nWidth, int nHeight, int nModes, size_t nFrameCount,
+                    Args... args) {
+
+  Game game(args...);
+
+  game.ConstructHeadless(nWidth, nHeight, nModes);
+
+  game.SetRandomSeed(nSeed);
+
+  game.SetFrameLimit(nFrameCount);
+
+  Script(game, nFrameCount, nWidth, nHeight);
+
+  size_t nStart = nAllocations.load();
+
+  game.Start();
+
+  return {game.FrameCount(), nAllocations.load() - nStart,
+          game.Metric(cb::NCursesGameEngine::METRIC_UPDATE_TIME),
+          game.Metric(cb::NCursesGameEngine::METRIC_PRESENT_TIME),
+          game.Metric(cb::NCursesGameEngine::METRIC_BYTES),
+          game.Metric(cb::NCursesGameEngine::METRIC_BYTES_SAVED)};
+}
+
+// runs a game twice, for nFrames and for twice as many frames: the statistics
+// of the second run cover its steady state, and the difference in allocations
+// leaves out those made by OnUserCreate and the engine setup
+template <typename Game, typename... Args>
+void Benchmark(const char *pName, int nModes, Args... args) {
+
+  for (auto &nSize : nSizes) {
+
+    Measurement sShort =
+        Measure<Game>(nSize[0], nSize[1], nModes, nFrames, args...);
+
+    Measurement sLong =
+        Measure<Game>(nSize[0], nSize[1], nModes, 2 * nFrames, args...);
+
+    size_t nExtraFrames = sLong.nFrames - sShort.nFrames;
+
+    printf("%s\n    {\"game\": \"%s\", \"modes\": %d, \"width\": %d, "
+           "\"height\": %d, \"frames_run\": %zu, \"update_ms\": %.4f, \"update_p99_ms\": %.4f, "
+           "\"present_ms\": %.4f, \"present_p99_ms\": %.4f, "
+           "\"bytes_per_frame\": %.1f, \"bytes_saved_per_frame\": %.1f, "
+           "\"allocations_per_frame\": %.2f}",
+           bFirstResult ? "" : ",", pName, nModes, nSize[0], nSize[1],
+           sLong.nFrames,
+           sLong.sUpdate.fAverage, sLong.sUpdate.fP99, sLong.sPresent.fAverage,
+           sLong.sPresent.fP99, sLong.sBytes.fAverage,
+           sLong.sBytesSaved.fAverage,
+           nExtraFrames ? static_cast<double>(sLong.nAllocations -
+                                              sShort.nAllocations) /
+                              static_cast<double>(nExtraFrames)
+                        : 0.0);
+
+    bFirstResult = false;
+  }
+}
+
+int main() {
+
+  const char *argv[] = {"GFXEngine", MODELS_DIR "/Teapot.obj"};
+
+  printf("{\n  \"seed\": %u,\n  \"frames\": %zu,\n  \"results\": [", nSeed,
+         nFrames);
+
+  Benchmark<A_Star>("A_Star", cb::NCursesGameEngine::MODE_DEFAULT);
+
+  Benchmark<GFXEngine>("GFXEngine", cb::NCursesGameEngine::MODE_DEFAULT, 2,
+                       argv);
+
+  Benchmark<GFXEngine>("GFXEngine", cb::NCursesGameEngine::MODE_BINNED, 2,
+                       argv);
+
+  Benchmark<GrandPrix>("GrandPrix", cb::NCursesGameEngine::MODE_DEFAULT);
+
+  Benchmark<PathFinding>("PathFinding", cb::NCursesGameEngine::MODE_DEFAULT);
+
+  Benchmark<SpriteEditor>("SpriteEditor", cb::NCursesGameEngine::MODE_DEFAULT,
+                          1, argv);
+
+  Benchmark<Tetris>("Tetris", cb::NCursesGameEngine::MODE_DEFAULT);
+
+  printf("\n  ]\n}\n");
+
+  return 0;
+}
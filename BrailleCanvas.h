@@ -0,0 +1,143 @@
+/**
+ *  @file   BrailleCanvas.h
+ *  @brief  Braille dot canvas for the NCursesGameEngine
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_BRAILLECANVAS_H
+#define CBNCURSESGAMEENGINE_BRAILLECANVAS_H
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cb {
+class BrailleCanvas;
+}; // namespace cb
+
+// A canvas of 2x4 dots per console cell. Every cell keeps its dots as the
+// eight bits of a byte, ordered as the dots of the Unicode Braille Patterns
+// block, so the glyph of a cell is simply U+2800 plus its mask.
+class cb::BrailleCanvas {
+
+public:
+  BrailleCanvas() {
+
+    nCellWidth = 0;
+    nCellHeight = 0;
+    nCellX = 0;
+    nCellY = 0;
+    pMasks = nullptr;
+    pColors = nullptr;
+  }
+
+  [[maybe_unused]] bool Create(int nWidth, int nHeight) {
+
+    if (nWidth * nHeight <= 0)
+      return false;
+
+    nCellWidth = nWidth;
+    nCellHeight = nHeight;
+
+    delete[] pMasks;
+    pMasks = new uint8_t[nCellWidth * nCellHeight];
+
+    delete[] pColors;
+    pColors = new short[nCellWidth * nCellHeight];
+
+    Clear();
+
+    return true;
+  }
+
+  ~BrailleCanvas() {
+
+    delete[] pMasks;
+    delete[] pColors;
+  }
+
+  BrailleCanvas(const BrailleCanvas &) = delete;
+
+  BrailleCanvas &operator=(const BrailleCanvas &) = delete;
+
+  [[maybe_unused]] inline void Set(int x, int y, short color) {
+
+    if (x < 0 || x >= 2 * nCellWidth || y < 0 || y >= 4 * nCellHeight)
+      return;
+
+    int i = (x >> 1) + (y >> 2) * nCellWidth;
+
+    pMasks[i] |= nDots[y & 3][x & 1];
+
+    pColors[i] = color;
+  }
+
+  [[maybe_unused]] inline void Unset(int x, int y) {
+
+    if (x < 0 || x >= 2 * nCellWidth || y < 0 || y >= 4 * nCellHeight)
+      return;
+
+    pMasks[(x >> 1) + (y >> 2) * nCellWidth] &=
+        static_cast<uint8_t>(~nDots[y & 3][x & 1]);
+  }
+
+  [[maybe_unused]] inline void Clear() {
+
+    std::fill_n(pMasks, nCellWidth * nCellHeight, 0);
+    std::fill_n(pColors, nCellWidth * nCellHeight, 0);
+  }
+
+  // places the canvas at console cell (x, y)
+  [[maybe_unused]] inline void SetPosition(int x, int y) {
+
+    nCellX = x;
+    nCellY = y;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline uint8_t Mask(int i) const {
+    return pMasks[i];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline short Color(int i) const {
+    return pColors[i];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline wchar_t Glyph(int i) const {
+    return static_cast<wchar_t>(0x2800 | pMasks[i]);
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int Width() const {
+    return 2 * nCellWidth;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int Height() const {
+    return 4 * nCellHeight;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int CellWidth() const {
+    return nCellWidth;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int CellHeight() const {
+    return nCellHeight;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline int CellX() const { return nCellX; }
+
+  [[maybe_unused]] [[nodiscard]] inline int CellY() const { return nCellY; }
+
+private:
+  int nCellWidth;
+  int nCellHeight;
+  int nCellX;
+  int nCellY;
+  uint8_t *pMasks;
+  short *pColors;
+
+  static constexpr uint8_t nDots[4][2] = {
+      {0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+};
+
+#endif // CBNCURSESGAMEENGINE_BRAILLECANVAS_H
@@ -19,6 +19,7 @@ class GFXEngine : public cb::NCursesGameEngine {
 
 public:
   GFXEngine(const int argc, const char *argv[]) {
+    SetTargetFPS(60.0f);
     if (argc > 1) {
       model = std::wstring(argv[1], argv[1] + strlen(argv[1]));
     } else {
@@ -60,18 +61,25 @@ public:
     cb::mat4x4 mWorld =
         RotationMatrixZ(fAngle) * RotationMatrixX(fAngle * 0.5f) * mTrans;
 
-    std::vector<cb::triangle3d> vRasterize;
+    // the triangles are transformed in parallel, each to its own slot, and
+    // those facing the camera are then collected in their original order
+    size_t nTriangles = mObj.triangles.size();
 
-    for (auto t : mObj.triangles) {
+    vTransformed.resize(nTriangles);
 
-      t = mWorld * t;
+    vVisible.resize(nTriangles);
+
+    ParallelFor(0, static_cast<int>(nTriangles), [&](int i) {
+      cb::triangle3d t = mWorld * mObj.triangles[i];
 
       cb::vec3d normal = (t.p2 - t.p1).cross(t.p3 - t.p1).normalize();
 
       float fDot = normal * (t.p1 - vCamera);
 
-      if (fDot >= 0.0f)
-        continue;
+      vVisible[i] = fDot < 0.0f;
+
+      if (!vVisible[i])
+        return;
 
       fDot = normal * vIllumination;
 
@@ -79,8 +87,14 @@ public:
 
       t.color = FG_GREY1 + (int)(24.0f * std::fabs(fDot));
 
-      vRasterize.emplace_back(t);
-    }
+      vTransformed[i] = t;
+    });
+
+    vRasterize.clear();
+
+    for (size_t i = 0; i < nTriangles; i++)
+      if (vVisible[i])
+        vRasterize.emplace_back(vTransformed[i]);
 
     std::sort(vRasterize.begin(), vRasterize.end(),
               [](const cb::triangle3d &a, const cb::triangle3d &b) {
@@ -101,6 +115,13 @@ public:
 
   cb::mesh mObj;
 
+  std::vector<cb::triangle3d> vTransformed;
+
+  // not a std::vector<bool>, whose elements cannot be set from two threads
+  std::vector<char> vVisible;
+
+  std::vector<cb::triangle3d> vRasterize;
+
   float fAngle;
 
   cb::mat4x4 mProj;
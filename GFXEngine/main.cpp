@@ -13,7 +13,8 @@ int main(const int argc, const char *argv[]) {
 
     GFXEngine gfx(argc, argv);
 
-    gfx.ConstructConsole();
+    gfx.ConstructConsole(cb::NCursesGameEngine::OUTPUT_NCURSES,
+                         cb::NCursesGameEngine::MODE_BINNED);
 
     gfx.Start();
 
@@ -12,6 +12,7 @@
 
 #include <cmath>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -300,7 +301,7 @@ struct [[maybe_unused]] cb::mesh {
   [[maybe_unused]] bool ReadObj(const std::wstring &filename) {
 
     std::ifstream ifstr;
-    ifstr.open(filename);
+    ifstr.open(std::filesystem::path(filename));
     if (ifstr.fail())
       return false;
 
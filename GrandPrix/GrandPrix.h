@@ -21,6 +21,8 @@ class GrandPrix : public cb::NCursesGameEngine {
 
     bool OnUserCreate() override {
 
+        SetTargetFPS( 60.0f );
+
         vTrack.emplace_back( 0.0f, 10.0f ); // start/finish
 
         for( int i = 0; i < 8; i++ ) vTrack.emplace_back( 2.0f * ( (float) rand() / RAND_MAX ) - 1.0f, (float) ( rand() % 500 ) );
@@ -29,6 +31,41 @@ class GrandPrix : public cb::NCursesGameEngine {
 
         lLapTimes = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
 
+        // the car as a sprite, with its blanks transparent so the road shows
+        const wchar_t *sCar[] = { L"      ^      ",
+                                  L"  ||-###-||  ",
+                                  L"      #      ",
+                                  L"||| ##### |||",
+                                  L"|||-#####-|||",
+                                  L"||| ##### |||",
+                                  L"     ###     ",
+                                  L" ~~~~^^^~~~~ " };
+
+        sprCar.Create( 13, 8 );
+
+        for( int y = 0; y < 8; y++ )
+            for( int x = 0; x < 13; x++ )
+                sprCar[ x + y * 13 ] = { sCar[ y ][ x ] == L' ' ? (wchar_t) PIXEL_TRANSPARENT : sCar[ y ][ x ], FG_WHITE, 0 };
+
+        // a tree for the roadside, drawn smaller the further away it is
+        const wchar_t *sTree[] = { L"   #   ",
+                                   L"  ###  ",
+                                   L" ##### ",
+                                   L"  ###  ",
+                                   L" ##### ",
+                                   L"#######",
+                                   L"   |   ",
+                                   L"   |   " };
+
+        sprTree.Create( 7, 8 );
+
+        for( int y = 0; y < 8; y++ )
+            for( int x = 0; x < 7; x++ )
+                sprTree[ x + y * 7 ] = { sTree[ y ][ x ] == L' ' ? (wchar_t) PIXEL_TRANSPARENT : ( sTree[ y ][ x ] == L'#' ? (wchar_t) PIXEL_FULL : (wchar_t) PIXEL_DARK ),
+                                         sTree[ y ][ x ] == L'#' ? FG_TEAL : FG_BROWN, 0 };
+
+        sprTree.GenerateMips();
+
         return true;
     }
 
@@ -130,15 +167,31 @@ class GrandPrix : public cb::NCursesGameEngine {
 
             int nCarYPos = ScreenHeight() - ( ScreenHeight() / 12 ) - 8;
 
+            // trees line the track every fTreeSpacing, drawn from far to near; a row
+            // at perspective p shows the track 2 * ScreenHeight() * ( 1 - p )^3 ahead,
+            // as do the stripes of the grass
+            float fRange = 2.0f * ScreenHeight();
+
+            for( int nTree = (int) ( ( fDistance + fRange ) / fTreeSpacing ); nTree * fTreeSpacing >= fDistance; nTree-- ) {
+
+                float fPerspective = 1.0f - std::cbrt( ( nTree * fTreeSpacing - fDistance ) / fRange );
+
+                float fMiddlePoint = 0.5f + fCurvature * powf( 1.0f - fPerspective, 3 );
+
+                float fRoadWidth = 0.1f + 0.8f * fPerspective;
+
+                float fScale = fPerspective * ScreenHeight() / 24.0f;
 
-            DrawAlphaString( nCarXPos, nCarYPos++, L"      ^      " );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"  ||-###-||  " );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"      #      " );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"||| ##### |||" );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"|||-#####-|||" );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"||| ##### |||" );
-            DrawAlphaString( nCarXPos, nCarYPos++, L"     ###     " );
-            DrawAlphaString( nCarXPos, nCarYPos,   L" ~~~~^^^~~~~");
+                float fOffset = ( 0.65f * fRoadWidth ) * ScreenWidth() + 0.5f * sprTree.SpriteWidth() * fScale + 1.0f;
+
+                float fY = ScreenHeight() / 2.0f * ( 1.0f + fPerspective ) - 0.5f * sprTree.SpriteHeight() * fScale;
+
+                DrawTransformedSprite( sprTree, fMiddlePoint * ScreenWidth() - fOffset, fY, fScale, fScale );
+
+                DrawTransformedSprite( sprTree, fMiddlePoint * ScreenWidth() + fOffset, fY, -fScale, fScale );
+            }
+
+            DrawSprite( sprCar, nCarXPos, nCarYPos );
 
 
             std::wstringstream ss;
@@ -190,6 +243,12 @@ private:
     float fTrackCurvature = 0.0f;
 
     float fPlayerCurvature = 0.0f;
+
+    cb::Sprite sprCar;
+
+    cb::Sprite sprTree;
+
+    static constexpr float fTreeSpacing = 12.0f;
 };
 
 #endif //CBNCURSESGAMEENDINGE_GRANDPRIX_H
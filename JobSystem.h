@@ -0,0 +1,273 @@
+/**
+ *  @file   JobSystem.h
+ *  @brief  Work-stealing job system for the NCursesGameEngine
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_JOBSYSTEM_H
+#define CBNCURSESGAMEENGINE_JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cb {
+class JobSystem;
+class TaskGroup;
+}; // namespace cb
+
+// Counts the tasks of a group that have not finished yet.
+class cb::TaskGroup {
+
+public:
+  TaskGroup() = default;
+
+  TaskGroup(const TaskGroup &) = delete;
+
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  [[maybe_unused]] [[nodiscard]] inline bool Done() const {
+    return 0 == nPending.load(std::memory_order_acquire);
+  }
+
+private:
+  friend class cb::JobSystem;
+
+  std::atomic<int> nPending{0};
+};
+
+// A pool of threads that each own a queue of tasks. A thread takes the task
+// it queued last, and when it runs out steals the oldest task of another
+// queue. Threads outside the pool queue to the first queue, and help run
+// tasks while they wait for them.
+class cb::JobSystem {
+
+public:
+  JobSystem() = default;
+
+  ~JobSystem() { Stop(); }
+
+  JobSystem(const JobSystem &) = delete;
+
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // nThreads counts the thread that waits, so nThreads - 1 are started
+  [[maybe_unused]] void Start(unsigned nThreads) {
+
+    Stop();
+
+    nThreads = std::max(nThreads, 1u);
+
+    bStop = false;
+
+    for (unsigned i = 0; i < nThreads; i++)
+      vQueues.emplace_back(std::make_unique<Queue>());
+
+    for (unsigned i = 1; i < nThreads; i++)
+      vThreads.emplace_back(&JobSystem::WorkerThread, this, i);
+  }
+
+  [[maybe_unused]] void Stop() {
+
+    if (vQueues.empty())
+      return;
+
+    WaitAll();
+
+    {
+      std::lock_guard<std::mutex> lock(mSleep);
+      bStop = true;
+    }
+
+    cvSleep.notify_all();
+
+    for (auto &thread : vThreads)
+      thread.join();
+
+    vThreads.clear();
+
+    vQueues.clear();
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline unsigned Threads() const {
+    return std::max(static_cast<unsigned>(vQueues.size()), 1u);
+  }
+
+  // runs right away when the pool is not started
+  [[maybe_unused]] void Run(cb::TaskGroup &group, std::function<void()> fTask) {
+
+    if (vQueues.empty()) {
+      fTask();
+      return;
+    }
+
+    group.nPending.fetch_add(1, std::memory_order_relaxed);
+
+    nOutstanding.fetch_add(1, std::memory_order_relaxed);
+
+    Queue &queue = *vQueues[pWorkerPool == this ? nWorkerIndex : 0];
+
+    {
+      std::lock_guard<std::mutex> lock(queue.mTasks);
+      queue.dTasks.push_back({std::move(fTask), &group});
+    }
+
+    nQueued.fetch_add(1, std::memory_order_release);
+
+    {
+      std::lock_guard<std::mutex> lock(mSleep);
+    }
+
+    cvSleep.notify_one();
+  }
+
+  // runs queued tasks until those of the group have finished
+  [[maybe_unused]] void Wait(const cb::TaskGroup &group) {
+
+    while (!group.Done())
+      if (!RunOne())
+        std::this_thread::yield();
+  }
+
+  [[maybe_unused]] void WaitAll() {
+
+    while (0 != nOutstanding.load(std::memory_order_acquire))
+      if (!RunOne())
+        std::this_thread::yield();
+  }
+
+  // calls fBody(i) for every i in [nBegin, nEnd) in chunks of nGrain, by
+  // default some four chunks per thread
+  template <typename F>
+  [[maybe_unused]] void ParallelFor(int nBegin, int nEnd, F &&fBody,
+                                    int nGrain = 0) {
+
+    if (nEnd <= nBegin)
+      return;
+
+    if (nGrain <= 0)
+      nGrain = std::max(1, (nEnd - nBegin) / static_cast<int>(4 * Threads()));
+
+    cb::TaskGroup group;
+
+    for (int i = nBegin; i < nEnd; i += nGrain) {
+
+      int j = std::min(nEnd - i, nGrain) + i;
+
+      Run(group, [&fBody, i, j] {
+        for (int k = i; k < j; k++)
+          fBody(k);
+      });
+    }
+
+    Wait(group);
+  }
+
+private:
+  typedef struct {
+    std::function<void()> fTask;
+    cb::TaskGroup *pGroup;
+  } Task;
+
+  typedef struct {
+    std::mutex mTasks;
+    std::deque<Task> dTasks;
+  } Queue;
+
+  // the own queue from the back, then the other ones from the front
+  bool RunOne() {
+
+    if (vQueues.empty())
+      return false;
+
+    unsigned nOwn = pWorkerPool == this ? nWorkerIndex : 0;
+
+    Task task;
+
+    for (unsigned n = 0; n < vQueues.size(); n++) {
+
+      Queue &queue = *vQueues[(nOwn + n) % vQueues.size()];
+
+      std::lock_guard<std::mutex> lock(queue.mTasks);
+
+      if (queue.dTasks.empty())
+        continue;
+
+      if (0 == n) {
+        task = std::move(queue.dTasks.back());
+        queue.dTasks.pop_back();
+      } else {
+        task = std::move(queue.dTasks.front());
+        queue.dTasks.pop_front();
+      }
+
+      break;
+    }
+
+    if (!task.fTask)
+      return false;
+
+    nQueued.fetch_sub(1, std::memory_order_relaxed);
+
+    task.fTask();
+
+    task.pGroup->nPending.fetch_sub(1, std::memory_order_release);
+
+    nOutstanding.fetch_sub(1, std::memory_order_release);
+
+    return true;
+  }
+
+  void WorkerThread(unsigned nIndex) {
+
+    pWorkerPool = this;
+
+    nWorkerIndex = nIndex;
+
+    while (true) {
+
+      if (RunOne())
+        continue;
+
+      std::unique_lock<std::mutex> lock(mSleep);
+
+      cvSleep.wait(lock, [this] {
+        return bStop || 0 < nQueued.load(std::memory_order_acquire);
+      });
+
+      if (bStop)
+        break;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> vQueues;
+
+  std::vector<std::thread> vThreads;
+
+  // queued and not yet taken, and queued and not yet finished
+  std::atomic<int> nQueued{0};
+
+  std::atomic<int> nOutstanding{0};
+
+  std::mutex mSleep;
+
+  std::condition_variable cvSleep;
+
+  bool bStop{false};
+
+  // the pool and queue of the running thread, if it is a worker
+  inline static thread_local JobSystem *pWorkerPool = nullptr;
+
+  inline static thread_local unsigned nWorkerIndex = 0;
+};
+
+#endif // CBNCURSESGAMEENGINE_JOBSYSTEM_H
@@ -11,24 +11,88 @@
 #define CBNCURSESGAMEENGINE_NCURSESGAMEENGINE_H
 
 extern "C" {
+#ifdef __APPLE__
 #include <Carbon/Carbon.h>
+#endif
 #include <X11/Xlib.h>
+#include <fcntl.h>
 #include <ncurses.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
 }
+#include "Atlas.h"
+#include "BrailleCanvas.h"
+#include "JobSystem.h"
+#include "Recording.h"
+#include "RingBuffer.h"
+#ifndef __APPLE__
+#include "KeyCodes.h"
+#endif
 #include "Sprite.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <clocale>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <new>
 #include <string>
 #include <thread>
 #include <vector>
 
 namespace cb {
 class NCursesGameEngine;
+typedef struct {
+  float fLast;
+  float fMin;
+  float fAverage;
+  float fP99;
+} MetricSummary;
+// a screen cell packed in 8 bytes; attributes are kept zero until used so
+// that cells compare, fill and copy as a whole
+typedef struct alignas(8) {
+  wchar_t character;
+  short color;
+  short attributes;
+} Cell;
+// the colors of a cell in truecolor mode, as 0xRRGGBB
+typedef struct alignas(8) {
+  uint32_t foreground;
+  uint32_t background;
+} CellColors;
+static_assert(sizeof(Pixel) == sizeof(Cell) &&
+                  offsetof(Pixel, color) == offsetof(Cell, color) &&
+                  offsetof(Pixel, reserved) == offsetof(Cell, attributes),
+              "sprite pixels are expected to be laid out as cells");
+// a key or mouse event as read from the terminal; nAction is one of the
+// actions, or for a change of focus whether it was gained, nButtons the
+// bstate of ncurses and (x, y) the screen position. A drag reports
+// REPORT_MOUSE_POSITION together with the PRESSED bit of the button held.
+typedef struct {
+  short nType;
+  short nAction;
+  uint16_t nKey;
+  mmask_t nButtons;
+  int x;
+  int y;
+  std::chrono::steady_clock::time_point tpTime;
+} InputEvent;
 };
 
+static_assert(sizeof(cb::Cell) == 8, "cb::Cell is expected to pack in 8 bytes");
+
 class cb::NCursesGameEngine {
 
 public:
@@ -41,9 +105,35 @@ public:
       FG_GREY15,   FG_GREY16, FG_GREY17,  FG_GREY18, FG_GREY20, FG_GREY21,
       FG_GREY22,   FG_GREY23, FG_GREY24,  FG_GREY25, FG_GREY26, FG_COLORS};
 
+  enum [[maybe_unused]] outputs : short{OUTPUT_NCURSES = 0, OUTPUT_ANSI,
+                                       OUTPUT_HEADLESS};
+
+  enum [[maybe_unused]] modes : int{MODE_DEFAULT = 0, MODE_TRUECOLOR = 1 << 0,
+                                    MODE_HALFBLOCK = 1 << 1,
+                                    MODE_PIPELINED = 1 << 2,
+                                    MODE_BINNED = 1 << 3,
+                                    MODE_KITTY_KEYS = 1 << 4};
+
+  enum [[maybe_unused]] metrics : short{
+      METRIC_UPDATE_TIME = 0, METRIC_PRESENT_TIME,  METRIC_INPUT_TIME,
+      METRIC_BYTES,           METRIC_CHANGED_CELLS, METRIC_COLOR_SWITCHES,
+      METRIC_BYTES_SAVED,     METRIC_COUNT};
+
   enum [[maybe_unused]] pixels : short{
       PIXEL_FULL = L'\u2588', PIXEL_LIGHT = L'\u2591', PIXEL_MEDIUM = L'\u2592',
-      PIXEL_DARK = L'\u2593'};
+      PIXEL_DARK = L'\u2593', PIXEL_UPPER = L'\u2580',
+      PIXEL_LOWER = L'\u2584',
+      PIXEL_TRANSPARENT = cb::Sprite::cTransparent};
+
+  enum [[maybe_unused]] layers : short{LAYER_BACKGROUND = 0, LAYER_WORLD,
+                                      LAYER_UI, LAYER_COUNT};
+
+  enum [[maybe_unused]] events : short{EVENT_KEY = 0, EVENT_MOUSE,
+                                      EVENT_RESIZE, EVENT_FOCUS};
+
+  // ACTION_STRUCK is a key typed without telling when it is released
+  enum [[maybe_unused]] actions : short{ACTION_STRUCK = 0, ACTION_PRESS,
+                                       ACTION_REPEAT, ACTION_RELEASE};
 
   NCursesGameEngine() {
 
@@ -51,17 +141,99 @@ public:
 
     nScreenHeight = 0;
 
+    nConsoleHeight = 0;
+
+    nPixelRows = 1;
+
+    nRowStride = 0;
+
     nColors = 0;
 
-    nScreenBufferColors = nullptr;
+    pScreenBuffer = nullptr;
+
+    pFrontBuffer = nullptr;
+
+    fTargetFrameTime = 0.0f;
+
+    fFixedTimestep = 0.0f;
+
+    fFixedAccumulator = 0.0f;
+
+    nMetricsFrames = 0;
+
+    nPresentChangedCells = 0;
+
+    nPresentColorSwitches = 0;
+
+    fPresentTime = 0.0f;
+
+    pScreenColors = nullptr;
+
+    pFrontColors = nullptr;
+
+    bTrueColor = false;
+
+    pDrawTarget = nullptr;
+
+    pDrawBuffer = nullptr;
+
+    pDrawColors = nullptr;
+
+    pDrawDirty = nullptr;
+
+    bLayered = false;
+
+    nLayer = LAYER_WORLD;
+
+    bCanvasesComposed = false;
+
+    bBinned = false;
+
+    nTilesX = 0;
+
+    nTilesY = 0;
+
+    nWorkerThreads = 0;
 
-    nScreenBufferCharacters = nullptr;
+    bPipelined = false;
+
+    nPipelineState = 0;
+
+    fPendingElapsedTime = 0.0f;
+
+    pPendingBuffer = nullptr;
+
+    pPendingColors = nullptr;
+
+    for (short i = 0; i < FG_COLORS - 1; i++)
+      nPalette[i + 1] = ColorRGB((rgb[i].r * 255) / 999,
+                                 (rgb[i].g * 255) / 999,
+                                 (rgb[i].b * 255) / 999);
+
+    nPalette[FG_NONE] = nPalette[FG_GREY];
 
     memset(&kmKeys, 0, sizeof(kmKeys));
 
     memset(&kmKeysPrevious, 0, sizeof(kmKeysPrevious));
 
-    mEvent = {};
+    memset(&kmKeysHeld, 0, sizeof(kmKeysHeld));
+
+    memset(&kmKeysStruck, 0, sizeof(kmKeysStruck));
+
+    bKittyKeys = false;
+
+    bKittyReleases = false;
+
+    nEventsPolled = 0;
+
+    nLastButton = 0;
+
+    bPendingClick = false;
+
+    for (int i = 0; i < 3; i++)
+      nClicks[i] = 0;
+
+    bMotion = false;
 
     bShowFPS = true;
 
@@ -70,31 +242,100 @@ public:
     XDisplay = nullptr;
 
     nWindowID = 0;
+
+    nOutput = OUTPUT_NCURSES;
+
+    nFrameBytes = 0;
+
+    bRepeatGlyphs = false;
+
+    bEraseLines = false;
+
+    nRepeatGlyph = L'\0';
+
+    nRepeatGlyphBytes = 0;
+
+    nRepeatCount = 0;
+
+    nCursorColumn = 0;
+
+    nPresentBytesSaved = 0;
+
+    nFrameCount = 0;
+
+    nFrameLimit = 0;
+
+    nScriptedKey = 0;
+
+    nScriptedMouse = 0;
+
+    nRandomSeed = 0;
+
+    bRandomSeed = false;
   }
 
   ~NCursesGameEngine() {
 
     OnUserDestroy();
 
-    if (has_colors())
-      if (can_change_color())
-        for (short i; i < static_cast<short>(nColors); i++)
-          init_color(i, rgb[i].r, rgb[i].g, rgb[i].b);
+    // nothing to restore when the console was never constructed
+    if (OUTPUT_HEADLESS != nOutput && nullptr != stdscr) {
+
+      // pops the keyboard flags pushed by ConstructConsole
+      if (bKittyKeys)
+        WriteTerminal("\x1b[<u");
+
+      WriteTerminal("\x1b[?1004l\x1b[?1006l\x1b[?1002l");
 
-    endwin();
+      if (has_colors())
+        if (can_change_color())
+          for (short i = 0; i < static_cast<short>(nColors); i++)
+            init_color(i, rgb[i].r, rgb[i].g, rgb[i].b);
 
-    delete nScreenBufferColors;
+      endwin();
+    }
 
-    delete nScreenBufferCharacters;
+    FreeScreenBuffers();
 
     if (focus.joinable())
       focus.join();
 
     if (nullptr != XDisplay)
       XCloseDisplay(XDisplay);
+
+    if (nWakePipe[0] >= 0) {
+
+      signal(SIGWINCH, SIG_DFL);
+
+      close(nWakePipe[0]);
+
+      close(nWakePipe[1]);
+
+      nWakePipe[0] = nWakePipe[1] = -1;
+    }
   }
 
-  void ConstructConsole() {
+  void ConstructConsole(outputs output = OUTPUT_NCURSES,
+                        int nModes = MODE_DEFAULT) {
+
+    bTrueColor = nModes & MODE_TRUECOLOR;
+
+    nPixelRows = (nModes & MODE_HALFBLOCK) ? 2 : 1;
+
+    bPipelined = nModes & MODE_PIPELINED;
+
+    bBinned = nModes & MODE_BINNED;
+
+#ifdef __APPLE__
+    bKittyKeys = nModes & MODE_KITTY_KEYS;
+#else
+    bKittyKeys = true;
+#endif
+
+    // ncurses has no notion of 24-bit color nor of background colors other
+    // than black, nor can it be used from two threads
+    nOutput = (bTrueColor || 2 == nPixelRows || bPipelined) ? OUTPUT_ANSI
+                                                            : output;
 
     XDisplay = XOpenDisplay(nullptr);
 
@@ -140,32 +381,242 @@ public:
 
     keypad(stdscr, true);
 
-    mousemask(ALL_MOUSE_EVENTS | REPORT_MOUSE_POSITION, nullptr);
+    // input is read by InputThread rather than ncurses, which therefore
+    // should not look for it while it refreshes
+    typeahead(-1);
+
+    sInput.reserve(256);
+
+    // reports presses, releases and drags of mouse buttons in the SGR
+    // encoding, which has no limit on the position, and the terminal gaining
+    // and losing focus
+    WriteTerminal("\x1b[?1002h\x1b[?1006h\x1b[?1004h");
+
+    // a resize wakes InputThread, that has the game thread handle it
+    if (0 == pipe(nWakePipe)) {
+
+      fcntl(nWakePipe[1], F_SETFL, O_NONBLOCK);
+
+      struct sigaction sAction {};
+
+      sAction.sa_handler = OnWindowChange;
+
+      sigemptyset(&sAction.sa_mask);
+
+      sAction.sa_flags = SA_RESTART;
+
+      sigaction(SIGWINCH, &sAction, nullptr);
+    }
+
+    if (bKittyKeys) {
+
+      // asks for press, repeat and release events of every key, and whether
+      // the terminal understood that; the device attributes are asked for as
+      // all terminals reply to those
+      WriteTerminal("\x1b[>11u\x1b[?u\x1b[c");
+    }
+
+    // REP repeats the last glyph, and with back color erase an erase to the
+    // end of the line fills with the current background
+    char cRepeat[] = "rep", cBackColorErase[] = "bce";
+
+    char *pRepeat = tigetstr(cRepeat);
+
+    bRepeatGlyphs =
+        nullptr != pRepeat && reinterpret_cast<char *>(-1) != pRepeat;
+
+    bEraseLines = tigetflag(cBackColorErase) > 0;
+
+    getmaxyx(stdscr, nConsoleHeight, nScreenWidth);
+
+    nScreenHeight = nConsoleHeight * nPixelRows;
 
-    getmaxyx(stdscr, nScreenHeight, nScreenWidth);
+    AllocateScreenBuffers();
 
-    nScreenBufferColors = new short[nScreenWidth * nScreenHeight];
+    if (OUTPUT_ANSI == nOutput) {
 
-    std::fill_n(nScreenBufferColors, nScreenWidth * nScreenHeight, FG_BLACK);
+      sFrame.reserve(nScreenWidth * nScreenHeight * 4);
 
-    nScreenBufferCharacters = new wchar_t[nScreenWidth * nScreenHeight];
+      // let ncurses clear the screen now, it would otherwise do so on the
+      // first getch() and wipe the first frame written past it
+      refresh();
+    }
+  }
+
+  // runs without a terminal: frames are encoded as with OUTPUT_ANSI but kept
+  // in memory, input comes from ScriptKey() and ScriptMouse() and every frame
+  // advances the clock by a fixed step, so a run is repeatable
+  [[maybe_unused]] void ConstructHeadless(int nWidth, int nHeight,
+                                          int nModes = MODE_DEFAULT) {
+
+    bTrueColor = nModes & MODE_TRUECOLOR;
+
+    nPixelRows = (nModes & MODE_HALFBLOCK) ? 2 : 1;
+
+    bPipelined = nModes & MODE_PIPELINED;
+
+    bBinned = nModes & MODE_BINNED;
+
+    nOutput = OUTPUT_HEADLESS;
 
-    std::fill_n(nScreenBufferCharacters, nScreenWidth * nScreenHeight,
-                PIXEL_FULL);
+    nColors = FG_COLORS;
+
+    // frames are encoded as for a terminal that supports both
+    bRepeatGlyphs = true;
+
+    bEraseLines = true;
+
+    nScreenWidth = nWidth;
+
+    nConsoleHeight = nHeight;
+
+    nScreenHeight = nConsoleHeight * nPixelRows;
+
+    AllocateScreenBuffers();
+
+    sFrame.reserve(nScreenWidth * nScreenHeight * 4);
   }
 
   [[maybe_unused]] void Start() {
 
     m_bAtomFocused = true;
 
-    if (nullptr != XDisplay && 0 != nWindowID)
+    if (nullptr != XDisplay && 0 != nWindowID && 0 == pipe(nFocusPipe))
       focus = std::thread(&NCursesGameEngine::FocusThread, this);
 
     m_bAtomActive = true;
 
+    if (bPipelined)
+      output = std::thread(&NCursesGameEngine::OutputThread, this);
+
+    if (nWakePipe[0] >= 0)
+      input = std::thread(&NCursesGameEngine::InputThread, this);
+
+    jobs.Start(0 != nWorkerThreads ? nWorkerThreads
+                                   : std::thread::hardware_concurrency());
+
     loop = std::thread(&NCursesGameEngine::GameThread, this);
 
     loop.join();
+
+    if (focus.joinable()) {
+
+      [[maybe_unused]] ssize_t n = write(nFocusPipe[1], &cWakeStop, 1);
+
+      focus.join();
+
+      close(nFocusPipe[0]);
+
+      close(nFocusPipe[1]);
+    }
+
+    if (input.joinable()) {
+
+      WakeInputThread(cWakeStop);
+
+      input.join();
+    }
+
+    jobs.Stop();
+  }
+
+  // the number of threads of the job system, counting the game thread that
+  // helps while it waits; 0, the default, is one per core
+  [[maybe_unused]] inline void SetWorkerThreads(unsigned nThreads) {
+    nWorkerThreads = nThreads;
+  }
+
+  [[maybe_unused]] inline unsigned WorkerThreads() const {
+    return jobs.Threads();
+  }
+
+  // calls fBody(i) for every i in [nBegin, nEnd) on the job system, nGrain
+  // iterations at a time, and returns when all are done
+  template <typename F>
+  [[maybe_unused]] inline void ParallelFor(int nBegin, int nEnd, F &&fBody,
+                                           int nGrain = 0) {
+    jobs.ParallelFor(nBegin, nEnd, std::forward<F>(fBody), nGrain);
+  }
+
+  [[maybe_unused]] inline void RunTask(cb::TaskGroup &group,
+                                       std::function<void()> fTask) {
+    jobs.Run(group, std::move(fTask));
+  }
+
+  // helps to run tasks until those of the group have finished
+  [[maybe_unused]] inline void WaitForTasks(const cb::TaskGroup &group) {
+    jobs.Wait(group);
+  }
+
+  [[maybe_unused]] inline void WaitForAllTasks() { jobs.WaitAll(); }
+
+  // ends the game after nFrames frames, 0 runs until OnUserUpdate returns false
+  [[maybe_unused]] inline void SetFrameLimit(size_t nFrames) {
+    nFrameLimit = nFrames;
+  }
+
+  [[maybe_unused]] inline size_t FrameCount() const { return nFrameCount; }
+
+  // seeds rand() before OnUserCreate, so a run can be repeated
+  [[maybe_unused]] inline void SetRandomSeed(unsigned nSeed) {
+
+    nRandomSeed = nSeed;
+
+    bRandomSeed = true;
+  }
+
+  // the seed for games to pass to srand(), the current time unless set
+  [[maybe_unused]] inline unsigned RandomSeed() const {
+    return bRandomSeed ? nRandomSeed : static_cast<unsigned>(time(nullptr));
+  }
+
+  // presses or releases a key from the given frame on, headless only
+  [[maybe_unused]] void ScriptKey(size_t nFrame, uint16_t nKey,
+                                  bool bPressed) {
+
+    ScriptedKey sKey = {nFrame, nKey, bPressed};
+
+    vScriptedKeys.insert(std::upper_bound(vScriptedKeys.begin(),
+                                          vScriptedKeys.end(), sKey,
+                                          [](const ScriptedKey &a,
+                                             const ScriptedKey &b) {
+                                            return a.nFrame < b.nFrame;
+                                          }),
+                         sKey);
+  }
+
+  // reports a mouse event at console cell (x, y) during the given frame,
+  // headless only
+  [[maybe_unused]] void ScriptMouse(size_t nFrame, long button, int x, int y) {
+
+    MEVENT sEvent{};
+
+    sEvent.x = x;
+
+    sEvent.y = y;
+
+    sEvent.bstate = button;
+
+    vScriptedMice.insert(
+        std::upper_bound(vScriptedMice.begin(), vScriptedMice.end(), nFrame,
+                         [](size_t n, const std::pair<size_t, MEVENT> &m) {
+                           return n < m.first;
+                         }),
+        {nFrame, sEvent});
+  }
+
+  // what the last presented frame shows at (x, y)
+  [[maybe_unused]] inline wchar_t PresentedCharacter(int x, int y) const {
+    return pFrontBuffer[x + y * nRowStride].character;
+  }
+
+  [[maybe_unused]] inline short PresentedColor(int x, int y) const {
+    return pFrontBuffer[x + y * nRowStride].color;
+  }
+
+  // the terminal output of the last frame
+  [[maybe_unused]] inline const std::string &FrameOutput() const {
+    return sFrame;
   }
 
   [[maybe_unused]] inline bool KeyPressed(uint16_t nKey) {
@@ -187,16 +638,31 @@ public:
            (!KeyPressed(nKey));
   }
 
+  // the input events of this frame in the order they arrived, one per call,
+  // which does not change what KeyPressed() or MousePressed() report
+  [[maybe_unused]] inline bool PollEvent(cb::InputEvent &event) {
+
+    if (nEventsPolled == vEvents.size())
+      return false;
+
+    event = vEvents[nEventsPolled++];
+
+    return true;
+  }
+
+  // whether any mouse event of this frame has one of the buttons, placing
+  // (x, y) at the last of those
   [[maybe_unused]] inline bool MousePressed(long button, int &x, int &y) const {
 
-    if (button & mEvent.bstate) {
+    for (auto event = vEvents.rbegin(); event != vEvents.rend(); ++event)
+      if (EVENT_MOUSE == event->nType && (button & event->nButtons)) {
 
-      x = mEvent.x;
+        x = event->x;
 
-      y = mEvent.y;
+        y = event->y;
 
-      return true;
-    }
+        return true;
+      }
 
     return false;
   }
@@ -205,38 +671,105 @@ public:
                                          wchar_t character = PIXEL_FULL,
                                          short color = FG_WHITE) {
 
+    if (nullptr != pDrawTarget) {
+      pDrawTarget->Set(x, y, color);
+      return;
+    }
+
+    if (x < 0 || x >= nScreenWidth || y < 0 || y >= nScreenHeight)
+      return;
+
+    FlushDrawCommands();
+
+    SetCell(x + y * nRowStride, character, color);
+  }
+
+  [[maybe_unused]] inline void DrawPixel(int x, int y, wchar_t character,
+                                         uint32_t foreground,
+                                         uint32_t background) {
+
+    if (nullptr != pDrawTarget) {
+      pDrawTarget->Set(x, y, NearestColor(foreground));
+      return;
+    }
+
     if (x < 0 || x >= nScreenWidth || y < 0 || y >= nScreenHeight)
       return;
 
-    nScreenBufferColors[x + y * nScreenWidth] = color;
+    FlushDrawCommands();
+
+    SetCell(x + y * nRowStride, character, foreground, background);
+  }
+
+  // a horizontal run of cells from x1 to x2 on row y, clipped once rather
+  // than per cell; the filled shapes are drawn as such spans
+  [[maybe_unused]] inline void DrawSpan(int x1, int x2, int y,
+                                        wchar_t character = PIXEL_FULL,
+                                        short color = FG_WHITE) {
+
+    if (x1 > x2)
+      std::swap(x1, x2);
+
+    if (Recording()) {
+
+      RecordDrawCommand({COMMAND_RECTANGLE, character, color, 0, 0, 0, 0, 0, 0,
+                         nullptr, x1, y, x2, y});
+      return;
+    }
+
+    if (y < 0 || y >= ScreenHeight())
+      return;
+
+    x1 = std::max(x1, 0);
+
+    x2 = std::min(x2, ScreenWidth() - 1);
+
+    if (x1 > x2)
+      return;
+
+    if (nullptr != pDrawTarget) {
+
+      for (int x = x1; x <= x2; x++)
+        pDrawTarget->Set(x, y, color);
+
+      return;
+    }
+
+    FlushDrawCommands();
+
+    PutSpan(x1 + y * nRowStride, x2 - x1 + 1, character, color);
 
-    nScreenBufferCharacters[x + y * nScreenWidth] = character;
+    MarkDrawn();
   }
 
+  // clips the line to the screen before stepping it, so the cost depends on
+  // the part that is visible; the pixels drawn are those of the whole line
   [[maybe_unused]] inline void DrawLine(int x1, int y1, int x2, int y2,
                                         wchar_t character = PIXEL_FULL,
                                         short color = FG_WHITE) {
 
+    int x, y, err, nPixels;
+
+    if (!ClipLine(x1, y1, x2, y2, ScreenWidth(), ScreenHeight(), x, y, err,
+                  nPixels))
+      return;
+
+    StepLine(x, y, std::abs(x2 - x1), -std::abs(y2 - y1), (x1 < x2) ? 1 : -1,
+             (y1 < y2) ? 1 : -1, err, nPixels, character, color);
+  }
+
+  // DrawLine without clipping, for lines known to be on the screen
+  [[maybe_unused]] inline void DrawUnclippedLine(int x1, int y1, int x2,
+                                                 int y2,
+                                                 wchar_t character = PIXEL_FULL,
+                                                 short color = FG_WHITE) {
+
     int dx = std::abs(x2 - x1);
-    int sx = (x1 < x2) ? 1 : -1;
+
     int dy = -std::abs(y2 - y1);
-    int sy = (y1 < y2) ? 1 : -1;
-    int err = dx + dy;
 
-    while (true) {
-      DrawPixel(x1, y1, character, color);
-      if ((x1 == x2) && (y1 == y2))
-        break;
-      int e2 = 2 * err;
-      if (e2 >= dy) {
-        err += dy;
-        x1 += sx;
-      }
-      if (e2 <= dx) {
-        err += dx;
-        y1 += sy;
-      }
-    }
+    StepLine(x1, y1, dx, dy, (x1 < x2) ? 1 : -1, (y1 < y2) ? 1 : -1, dx + dy,
+             std::max(dx, -dy) + 1, character, color);
   }
 
   [[maybe_unused]] inline void DrawTriangle(int x1, int y1, int x2, int y2,
@@ -271,54 +804,22 @@ public:
       std::swap(x1, x2);
     }
 
-    int a, b, y, last;
-
-    if (y1 == y3) {
-
-      a = b = x1;
-
-      if (x2 < a)
-        a = x2;
-      else if (x2 > b)
-        b = x2;
-
-      if (x3 < a)
-        a = x3;
-      else if (x3 > b)
-        b = x3;
-
-      DrawLine(a, y1, b, y1, character, color);
+    if (Recording()) {
 
+      RecordDrawCommand({COMMAND_TRIANGLE, character, color, x1, y1, x2, y2,
+                         x3, y3, nullptr, std::min({x1, x2, x3}), y1,
+                         std::max({x1, x2, x3}), y3});
       return;
     }
 
-    int dx12 = x2 - x1, dy12 = y2 - y1, dx13 = x3 - x1, dy13 = y3 - y1,
-        dx23 = x3 - x2, dy23 = y3 - y2;
-
-    int sa = 0, sb = 0;
+    // any row can be asked for, so only the rows on the screen are walked
+    for (int y = std::max(y1, 0); y <= std::min(y3, ScreenHeight() - 1); y++) {
 
-    if (y2 == y3)
-      last = y2;
-    else
-      last = y2 - 1;
-
-    for (y = y1; y <= last; y++) {
+      int a, b;
 
-      a = x1 + sa / dy12;
-      b = x1 + sb / dy13;
-      sa += dx12;
-      sb += dx13;
-      DrawLine(a, y, b, y, character, color);
-    }
+      TriangleSpan(x1, y1, x2, y2, x3, y3, y, a, b);
 
-    sa = dx23 * (y - y2);
-    sb = dx13 * (y - y1);
-    for (; y <= y3; y++) {
-      a = x2 + sa / dy23;
-      b = x1 + sb / dy13;
-      sa += dx23;
-      sb += dx13;
-      DrawLine(a, y, b, y, character, color);
+      DrawSpan(a, b, y, character, color);
     }
   }
 
@@ -356,32 +857,19 @@ public:
                                                 wchar_t character = PIXEL_FULL,
                                                 short color = FG_WHITE) {
 
-    int x = 0;
-    int y = r;
-    int d = 3 - (2 * r);
-
-    auto Bresenham = [this](int xc, int yc, int x, int y, wchar_t character,
-                            short color) {
-      auto ScanLine = [this](int x0, int x1, int y, wchar_t character,
-                             short color) {
-        for (int x = x0; x <= x1; x++)
-          DrawPixel(x, y, character, color);
-      };
+    // the last step of the midpoint algorithm may reach one past r
+    if (Recording()) {
 
-      ScanLine(xc - x, xc + x, yc - y, character, color);
-      ScanLine(xc - y, xc + y, yc - x, character, color);
-      ScanLine(xc - x, xc + x, yc + y, character, color);
-      ScanLine(xc - y, xc + y, yc + x, character, color);
-    };
+      int e = std::abs(r) + 1;
 
-    Bresenham(xc, yc, x, y, character, color);
-    while (x <= y) {
-      if (d <= 0)
-        d = d + (4 * x++) + 6;
-      else
-        d = d + (4 * x++) - (4 * y--) + 10;
-      Bresenham(xc, yc, x, y, character, color);
+      RecordDrawCommand({COMMAND_CIRCLE, character, color, xc, yc, r, 0, 0, 0,
+                         nullptr, xc - e, yc - e, xc + e, yc + e});
+      return;
     }
+
+    CircleSpans(xc, yc, r, [&](int x0, int x1, int y) {
+      DrawSpan(x0, x1, y, character, color);
+    });
   }
 
   [[maybe_unused]] inline void DrawRectangle(int x1, int y1, int x2, int y2,
@@ -410,34 +898,47 @@ public:
     if (y1 > y2)
       std::swap(y1, y2);
 
-    for (int x = x1; x <= x2; x++) {
+    if (Recording()) {
 
-      if (x < 0 || x > nScreenWidth)
-        continue;
+      RecordDrawCommand({COMMAND_RECTANGLE, character, color, 0, 0, 0, 0, 0, 0,
+                         nullptr, x1, y1, x2, y2});
+      return;
+    }
+
+    for (int y = std::max(y1, 0); y <= std::min(y2, ScreenHeight() - 1); y++)
+      DrawSpan(x1, x2, y, character, color);
+  }
 
-      for (int y = y1; y <= y2; y++) {
+  [[maybe_unused]] inline void DrawString(int x, int y,
+                                          const std::wstring &str, int color = FG_WHITE) {
 
-        if (y < 0 || y > nScreenHeight)
-          continue;
+    if (x < 0 || x >= nScreenWidth || y < 0 || y >= nScreenHeight)
+      return;
 
-        nScreenBufferColors[x + y * nScreenWidth] = color;
+    FlushDrawCommands();
 
-        nScreenBufferCharacters[x + y * nScreenWidth] = character;
-      }
+    for (auto &c : str) {
+
+      SetCell(x + y * nRowStride, c, static_cast<short>(color));
+
+      if (++x >= nScreenWidth)
+        break;
     }
   }
 
   [[maybe_unused]] inline void DrawString(int x, int y,
-                                          const std::wstring &str, int color = FG_WHITE) {
+                                          const std::wstring &str,
+                                          uint32_t foreground,
+                                          uint32_t background) {
 
     if (x < 0 || x >= nScreenWidth || y < 0 || y >= nScreenHeight)
       return;
 
-    for (auto &c : str) {
+    FlushDrawCommands();
 
-      nScreenBufferColors[x + y * nScreenWidth] = color;
+    for (auto &c : str) {
 
-      nScreenBufferCharacters[x + y * nScreenWidth] = c;
+      SetCell(x + y * nRowStride, c, foreground, background);
 
       if (++x >= nScreenWidth)
         break;
@@ -450,14 +951,12 @@ public:
     if (x < 0 || x >= nScreenWidth || y < 0 || y >= nScreenHeight)
       return;
 
-    for (auto &c : str) {
-
-      if (c != L' ') {
+    FlushDrawCommands();
 
-        nScreenBufferColors[x + y * nScreenWidth] = color;
+    for (auto &c : str) {
 
-        nScreenBufferCharacters[x + y * nScreenWidth] = c;
-      }
+      if (c != L' ')
+        SetCell(x + y * nRowStride, c, static_cast<short>(color));
 
       if (++x >= nScreenWidth)
         break;
@@ -466,21 +965,181 @@ public:
 
   [[maybe_unused]] inline void DrawSprite(cb::Sprite &s, int x0, int y0) {
 
-    for (int x = 0; x < s.SpriteWidth(); x++) {
-      for (int y = 0; y < s.SpriteHeight(); y++) {
-        Pixel pixel = s[x + y * s.SpriteWidth()];
-        DrawPixel(x0 + x, y0 + y, pixel.character, pixel.color);
-      }
-    }
+    DrawSprite(s, x0, y0, 0, 0, s.SpriteWidth(), s.SpriteHeight());
+  }
+
+  // draws the rect nRect of the sheet of the atlas, as found by Find() or
+  // Frame()
+  [[maybe_unused]] inline void DrawSprite(cb::Atlas &atlas, int nRect, int x0,
+                                          int y0) {
+
+    const cb::Atlas::Rect &rect = atlas.RectAt(nRect);
+
+    DrawSprite(atlas.Sheet(), x0, y0, rect.x, rect.y, rect.nWidth,
+               rect.nHeight);
   }
 
+  // draws the part of s at (sx, sy) of width by height; pixels with the
+  // character PIXEL_TRANSPARENT are left out
   [[maybe_unused]] inline void DrawSprite(cb::Sprite &s, int x0, int y0, int sx,
                                           int sy, int width, int height) {
 
-    for (int x = 0; x < width; x++) {
-      for (int y = 0; y < height; y++) {
-        Pixel pixel = s[(x + sx) + (y + sy) * s.SpriteWidth()];
-        DrawPixel(x0 + x, y0 + y, pixel.character, pixel.color);
+    // clips the source to the sprite once
+    if (sx < 0) {
+      x0 -= sx;
+      width += sx;
+      sx = 0;
+    }
+
+    if (sy < 0) {
+      y0 -= sy;
+      height += sy;
+      sy = 0;
+    }
+
+    width = std::min(width, s.SpriteWidth() - sx);
+
+    height = std::min(height, s.SpriteHeight() - sy);
+
+    if (width <= 0 || height <= 0)
+      return;
+
+    s.IndexRuns();
+
+    if (nullptr != pDrawTarget) {
+
+      for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+
+          const cb::Pixel &pixel =
+              s.Pixels()[(x + sx) + (y + sy) * s.SpriteWidth()];
+
+          if (PIXEL_TRANSPARENT != pixel.character)
+            pDrawTarget->Set(x0 + x, y0 + y, pixel.color);
+        }
+
+      return;
+    }
+
+    if (Recording()) {
+
+      RecordDrawCommand({COMMAND_SPRITE, L'\0', 0, x0, y0, sx, sy, width,
+                         height, &s, x0, y0, x0 + width - 1, y0 + height - 1});
+      return;
+    }
+
+    // and the destination to the screen
+    int nLeft = std::max(x0, 0), nRight = std::min(x0 + width, nScreenWidth) - 1;
+
+    int nTop = std::max(y0, 0),
+        nBottom = std::min(y0 + height, nScreenHeight) - 1;
+
+    if (nLeft > nRight || nTop > nBottom)
+      return;
+
+    FlushDrawCommands();
+
+    BlitSprite(s, x0 - sx, y0 - sy, nLeft, nTop, nRight, nBottom);
+
+    MarkDrawn();
+  }
+
+  // draws s with its center at (x, y), scaled by fScaleX and fScaleY, which
+  // flip it when negative, and turned by fAngle radians, clockwise as y runs
+  // down; every cell of the bounding box on the screen is mapped back into
+  // the sprite in fixed point. Transparent pixels are left out, as with
+  // DrawSprite, and a sprite with mip levels is sampled from the level that
+  // is closest to, but not smaller than, the size it is drawn at.
+  [[maybe_unused]] inline void DrawTransformedSprite(cb::Sprite &s, float x,
+                                                     float y, float fScaleX,
+                                                     float fScaleY,
+                                                     float fAngle = 0.0f) {
+
+    if (0.0f == fScaleX || 0.0f == fScaleY || s.SpriteWidth() <= 0 ||
+        s.SpriteHeight() <= 0)
+      return;
+
+    s.UpdateMips();
+
+    float fScale = std::min(std::fabs(fScaleX), std::fabs(fScaleY));
+
+    int nLevel = 0;
+
+    while (nLevel + 1 < s.Levels() && fScale * (2 << nLevel) <= 1.0f)
+      nLevel++;
+
+    int nWidth, nHeight;
+
+    const cb::Pixel *pPixels = s.LevelPixels(nLevel, nWidth, nHeight);
+
+    double fCos = std::cos(fAngle), fSin = std::sin(fAngle);
+
+    double fHalfWidth = 0.5 * s.SpriteWidth() * fScaleX,
+           fHalfHeight = 0.5 * s.SpriteHeight() * fScaleY;
+
+    double fExtentX = std::fabs(fHalfWidth * fCos) + std::fabs(fHalfHeight * fSin),
+           fExtentY = std::fabs(fHalfWidth * fSin) + std::fabs(fHalfHeight * fCos);
+
+    // clipped before converting, as the box may lie far off the screen
+    double fLeft = std::max(0.0, std::floor(x - fExtentX)),
+           fRight = std::min(ScreenWidth() - 1.0, std::ceil(x + fExtentX));
+
+    double fTop = std::max(0.0, std::floor(y - fExtentY)),
+           fBottom = std::min(ScreenHeight() - 1.0, std::ceil(y + fExtentY));
+
+    if (!(fLeft <= fRight && fTop <= fBottom))
+      return;
+
+    int nLeft = static_cast<int>(fLeft), nRight = static_cast<int>(fRight);
+
+    int nTop = static_cast<int>(fTop), nBottom = static_cast<int>(fBottom);
+
+    // pixels of the level per cell, and the steps through the level along a
+    // row and down a column in 16.16 fixed point
+    double fU = nWidth / (s.SpriteWidth() * static_cast<double>(fScaleX)),
+           fV = nHeight / (s.SpriteHeight() * static_cast<double>(fScaleY));
+
+    auto Fixed = [](double f) { return std::llround(f * 65536.0); };
+
+    int64_t duX = Fixed(fCos * fU), dvX = Fixed(-fSin * fV);
+
+    int64_t duY = Fixed(fSin * fU), dvY = Fixed(fCos * fV);
+
+    // at the center of the top left cell
+    double dx = nLeft + 0.5 - x, dy = nTop + 0.5 - y;
+
+    int64_t uRow = Fixed((dx * fCos + dy * fSin) * fU + 0.5 * nWidth);
+
+    int64_t vRow = Fixed((dy * fCos - dx * fSin) * fV + 0.5 * nHeight);
+
+    if (nullptr == pDrawTarget) {
+
+      FlushDrawCommands();
+
+      MarkDrawn();
+    }
+
+    for (int cy = nTop; cy <= nBottom; cy++, uRow += duY, vRow += dvY) {
+
+      int64_t u = uRow, v = vRow;
+
+      for (int cx = nLeft; cx <= nRight; cx++, u += duX, v += dvX) {
+
+        // negative coordinates floor below zero and fail as well
+        int64_t su = u >> 16, sv = v >> 16;
+
+        if (su < 0 || su >= nWidth || sv < 0 || sv >= nHeight)
+          continue;
+
+        const cb::Pixel &pixel = pPixels[su + sv * nWidth];
+
+        if (PIXEL_TRANSPARENT == pixel.character)
+          continue;
+
+        if (nullptr != pDrawTarget)
+          pDrawTarget->Set(cx, cy, pixel.color);
+        else
+          PutCell(cx + cy * nRowStride, pixel.character, pixel.color);
       }
     }
   }
@@ -488,18 +1147,270 @@ public:
   [[maybe_unused]] inline void Clear(wchar_t character = PIXEL_FULL,
                                      short color = FG_WHITE) {
 
-    std::fill_n(nScreenBufferCharacters, nScreenWidth * nScreenHeight,
-                character);
+    if (nullptr != pDrawTarget) {
+      pDrawTarget->Clear();
+      return;
+    }
+
+    // drops what was recorded before, which the clear would overwrite
+    if (Recording()) {
+
+      vDrawCommands.clear();
+
+      for (auto &vBin : vBins)
+        vBin.clear();
+
+      RecordDrawCommand({COMMAND_RECTANGLE, character, color, 0, 0, 0, 0, 0, 0,
+                         nullptr, 0, 0, nScreenWidth - 1, nScreenHeight - 1});
+      return;
+    }
+
+    std::fill_n(pDrawBuffer, nRowStride * nScreenHeight,
+                cb::Cell{character, color, 0});
+
+    if (bTrueColor)
+      std::fill_n(pDrawColors, nRowStride * nScreenHeight,
+                  cb::CellColors{PaletteColor(color), nPalette[FG_BLACK]});
+
+    MarkDrawn();
+  }
+
+  [[maybe_unused]] inline void Clear(wchar_t character, uint32_t foreground,
+                                     uint32_t background) {
+
+    FlushDrawCommands();
+
+    if (bTrueColor) {
+
+      std::fill_n(pDrawBuffer, nRowStride * nScreenHeight,
+                  cb::Cell{character, FG_NONE, 0});
+
+      std::fill_n(pDrawColors, nRowStride * nScreenHeight,
+                  cb::CellColors{foreground, background});
+    } else
+      std::fill_n(pDrawBuffer, nRowStride * nScreenHeight,
+                  cb::Cell{character, NearestColor(foreground), 0});
+
+    MarkDrawn();
+  }
+
+  [[maybe_unused]] static constexpr uint32_t ColorRGB(int r, int g, int b) {
+
+    return (static_cast<uint32_t>(r & 0xFF) << 16) |
+           (static_cast<uint32_t>(g & 0xFF) << 8) |
+           static_cast<uint32_t>(b & 0xFF);
+  }
+
+  [[maybe_unused]] inline uint32_t PaletteColor(short color) const {
+
+    return nPalette[(color >= 0 && color < FG_COLORS)
+                        ? color
+                        : static_cast<short>(FG_NONE)];
+  }
+
+  [[maybe_unused]] inline short NearestColor(uint32_t color) const {
+
+    short nNearest = FG_BLACK;
+
+    int nDistance = INT32_MAX;
+
+    for (short i = FG_BLACK; i < FG_COLORS; i++) {
+
+      int dr = static_cast<int>((color >> 16) & 0xFF) -
+               static_cast<int>((nPalette[i] >> 16) & 0xFF);
+      int dg = static_cast<int>((color >> 8) & 0xFF) -
+               static_cast<int>((nPalette[i] >> 8) & 0xFF);
+      int db = static_cast<int>(color & 0xFF) -
+               static_cast<int>(nPalette[i] & 0xFF);
+
+      if (dr * dr + dg * dg + db * db < nDistance) {
+        nDistance = dr * dr + dg * dg + db * db;
+        nNearest = i;
+      }
+    }
+
+    return nNearest;
+  }
+
+  [[maybe_unused]] inline bool IsTrueColor() const { return bTrueColor; }
+
+  [[maybe_unused]] inline size_t FrameBytes() const { return nFrameBytes; }
+
+  // last, minimum, average and 99th percentile of a metric over the last
+  // nMetricsWindow frames; times are in milliseconds and bytes are only
+  // counted for the ANSI output as ncurses owns the terminal otherwise
+  [[maybe_unused]] cb::MetricSummary Metric(metrics metric) const {
+
+    cb::MetricSummary summary{0.0f, 0.0f, 0.0f, 0.0f};
+
+    size_t nFrames = std::min(nMetricsFrames, nMetricsWindow);
+
+    if (0 == nFrames || metric < 0 || metric >= METRIC_COUNT)
+      return summary;
+
+    std::vector<float> vValues(nFrames);
+
+    for (size_t i = 0; i < nFrames; i++)
+      vValues[i] = aMetrics[i][metric];
+
+    summary.fLast = aMetrics[(nMetricsFrames - 1) % nMetricsWindow][metric];
+
+    float fSum = 0.0f;
+
+    for (auto &fValue : vValues)
+      fSum += fValue;
+
+    summary.fAverage = fSum / static_cast<float>(nFrames);
+
+    std::sort(vValues.begin(), vValues.end());
+
+    summary.fMin = vValues.front();
+
+    summary.fP99 = vValues[(nFrames * 99 + 99) / 100 - 1];
+
+    return summary;
+  }
+
+  // keeps the metrics of every frame and writes them as CSV to filename when
+  // the game ends
+  [[maybe_unused]] void
+  SetMetricsFile(const std::filesystem::path &filename) {
+
+    pMetricsFile = filename;
+
+    vMetricsLog.clear();
+  }
+
+  // records every frame to filename, compressed on a thread of its own, to
+  // be replayed with the Player; false when the file can not be written, in
+  // which case nothing is recorded
+  [[maybe_unused]] bool
+  SetRecordingFile(const std::filesystem::path &filename) {
+
+    pRecordingFile.clear();
+
+    // the recording itself starts with the game, once its modes are known
+    if (std::ofstream(filename, std::ios::binary).fail())
+      return false;
+
+    pRecordingFile = filename;
+
+    return true;
+  }
+
+  // also false when the recording could not be started after all, or
+  // stopped as a write failed
+  [[maybe_unused]] [[nodiscard]] inline bool IsRecording() const {
+    return recorder.IsOpen() && !recorder.Failed();
+  }
+
+  // a write of the recording failed, which then stopped; the file holds the
+  // frames before, and stays so after the game ended
+  [[maybe_unused]] [[nodiscard]] inline bool RecordingFailed() const {
+    return recorder.Failed();
+  }
+
+  // the frames left out of the recording as its queue was full
+  [[maybe_unused]] inline size_t RecordingDroppedFrames() const {
+    return recorder.Dropped();
+  }
+
+  [[maybe_unused]] bool
+  DumpMetrics(const std::filesystem::path &filename) const {
+
+    std::ofstream ofstr(filename);
+
+    if (ofstr.fail())
+      return false;
+
+    ofstr << "frame,update_ms,present_ms,input_ms,bytes,changed_cells,"
+             "color_switches,bytes_saved\n";
+
+    for (size_t i = 0; i < vMetricsLog.size(); i++) {
+
+      ofstr << i;
+
+      for (auto &fValue : vMetricsLog[i])
+        ofstr << ',' << fValue;
+
+      ofstr << '\n';
+    }
+
+    return ofstr.good();
+  }
+
+  // routes DrawPixel and the line and shape primitives built on it to the
+  // dots of a Braille canvas until reset with nullptr, while strings still
+  // go to the screen as characters; every canvas targeted during a frame is
+  // composited over the screen right before it is presented
+  [[maybe_unused]] inline void SetDrawTarget(cb::BrailleCanvas *canvas) {
+
+    pDrawTarget = canvas;
 
-    std::fill_n(nScreenBufferColors, nScreenWidth * nScreenHeight, color);
+    if (nullptr != canvas &&
+        std::find(vCanvases.begin(), vCanvases.end(), canvas) ==
+            vCanvases.end())
+      vCanvases.emplace_back(canvas);
   }
 
-  [[maybe_unused]] inline int ScreenWidth() const { return nScreenWidth; }
+  // draws to one of the layers from now on; the first call replaces drawing
+  // straight to the screen by layers, cleared to PIXEL_TRANSPARENT, that are
+  // stacked in order and composited whenever one of them was drawn to
+  [[maybe_unused]] inline void SetLayer(layers layer) {
 
-  [[maybe_unused]] inline int ScreenHeight() const { return nScreenHeight; }
+    if (layer < 0 || layer >= LAYER_COUNT)
+      return;
+
+    FlushDrawCommands();
+
+    nLayer = layer;
+
+    if (!bLayered) {
+
+      bLayered = true;
+
+      AllocateLayers();
+    }
+
+    SelectDrawBuffers();
+  }
+
+  [[maybe_unused]] inline layers Layer() const { return nLayer; }
+
+  [[maybe_unused]] inline int ScreenWidth() const {
+    return nullptr != pDrawTarget ? pDrawTarget->Width() : nScreenWidth;
+  }
+
+  [[maybe_unused]] inline int ScreenHeight() const {
+    return nullptr != pDrawTarget ? pDrawTarget->Height() : nScreenHeight;
+  }
 
   [[maybe_unused]] inline bool IsFocused() { return m_bAtomFocused; }
 
+  // paces the game loop to fFPS frames per second by sleeping most of the
+  // remaining frame time and spinning the last nPacingSpinMicroseconds, zero
+  // runs as fast as possible
+  [[maybe_unused]] inline void SetTargetFPS(float fFPS) {
+
+    fTargetFrameTime = fFPS > 0.0f ? 1.0f / fFPS : 0.0f;
+  }
+
+  // calls OnUserFixedUpdate with a constant fStep as many times as the
+  // elapsed time allows before every OnUserUpdate, zero disables it
+  [[maybe_unused]] inline void SetFixedTimestep(float fStep) {
+
+    fFixedTimestep = fStep > 0.0f ? fStep : 0.0f;
+
+    fFixedAccumulator = 0.0f;
+  }
+
+  // the fraction of a fixed step left over, to interpolate the rendered state
+  // between the last two fixed updates
+  [[maybe_unused]] inline float FixedUpdateAlpha() const {
+
+    return fFixedTimestep > 0.0f ? fFixedAccumulator / fFixedTimestep : 0.0f;
+  }
+
   [[maybe_unused]] virtual void OnUserDestroy(){};
 
   [[maybe_unused]] virtual bool OnUserResize() { return true; }
@@ -508,120 +1419,2501 @@ public:
 
   [[maybe_unused]] virtual bool OnUserUpdate(float fElapsedTime) = 0;
 
+  [[maybe_unused]] virtual bool OnUserFixedUpdate(float /* fElapsedTime */) {
+    return true;
+  }
+
 private:
+  enum commands : short{COMMAND_RECTANGLE = 0, COMMAND_TRIANGLE,
+                        COMMAND_CIRCLE, COMMAND_SPRITE};
+
+  // the corners of a triangle sorted on y, the center and radius of a circle
+  // in x1, y1 and x2, or the position, source offset and size of a sprite;
+  // followed by the bounding box
+  typedef struct {
+    commands nType;
+    wchar_t character;
+    short color;
+    int x1, y1, x2, y2, x3, y3;
+    cb::Sprite *pSprite;
+    int nLeft, nTop, nRight, nBottom;
+  } DrawCommand;
+
+  // sleeps until the X server reports the focus of the terminal window
+  // changed, or it is woken through nFocusPipe to stop
   [[maybe_unused]] void FocusThread() {
 
     Window w;
     int r;
 
-    while (m_bAtomActive) {
+    // a stale WINDOWID would otherwise end the program with BadWindow
+    XSetErrorHandler([](Display *, XErrorEvent *) { return 0; });
+
+    XSelectInput(XDisplay, nWindowID, FocusChangeMask);
+
+    XGetInputFocus(XDisplay, &w, &r);
+
+    m_bAtomFocused = (nWindowID == w);
+
+    pollfd aDescriptors[2] = {{ConnectionNumber(XDisplay), POLLIN, 0},
+                              {nFocusPipe[0], POLLIN, 0}};
+
+    while (true) {
+
+      // also flushes the requests
+      while (XPending(XDisplay) > 0) {
+
+        XEvent event;
+
+        XNextEvent(XDisplay, &event);
+
+        if (FocusIn == event.type || FocusOut == event.type) {
 
-      XGetInputFocus(XDisplay, &w, &r);
+          XGetInputFocus(XDisplay, &w, &r);
 
-      m_bAtomFocused = (nWindowID == w);
+          m_bAtomFocused = (nWindowID == w);
+        }
+      }
+
+      if (poll(aDescriptors, 2, -1) < 0 && EINTR != errno)
+        break;
 
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      if (aDescriptors[1].revents & POLLIN)
+        break;
     }
   }
 
-  [[maybe_unused]] void GameThread() {
+  // fills nCount cells from i on with wide stores, as cells are 8 bytes and
+  // rows aligned; leaves the dirty flag alone like PutCell
+  inline void PutSpan(int i, int nCount, wchar_t character, short color) {
 
-    if (OnUserCreate()) {
+    std::fill_n(pDrawBuffer + i, nCount, cb::Cell{character, color, 0});
 
-      struct timespec sStartTimespec {
-      }, sStopTimespec{};
+    if (bTrueColor)
+      std::fill_n(pDrawColors + i, nCount,
+                  cb::CellColors{PaletteColor(color), nPalette[FG_BLACK]});
+  }
 
-      float fElapsedTime = 0.0f;
+  inline void SetCell(int i, wchar_t character, short color) {
 
-      clock_gettime(CLOCK_MONOTONIC_RAW, &sStartTimespec);
+    PutCell(i, character, color);
 
-      while (m_bAtomActive) {
+    MarkDrawn();
+  }
 
-        clock_gettime(CLOCK_MONOTONIC_RAW, &sStopTimespec);
+  // leaves the dirty flag alone, so the raster threads can write cells
+  inline void PutCell(int i, wchar_t character, short color) {
 
-        memcpy(&kmKeysPrevious, &kmKeys, sizeof(kmKeys));
+    pDrawBuffer[i] = {character, color, 0};
 
-        GetKeys(kmKeys);
+    if (bTrueColor)
+      pDrawColors[i] = {PaletteColor(color), nPalette[FG_BLACK]};
+  }
 
-        m_bAtomActive = OnUserUpdate(fElapsedTime);
+  // cells drawn in RGB carry no palette color in truecolor mode
+  inline void SetCell(int i, wchar_t character, uint32_t foreground,
+                      uint32_t background) {
 
-        fElapsedTime = (float)(sStopTimespec.tv_sec - sStartTimespec.tv_sec) +
-                       (float)(sStopTimespec.tv_nsec - sStartTimespec.tv_nsec) /
-                           1000000000.0f;
+    if (bTrueColor) {
 
-        short nColor = *nScreenBufferColors;
+      pDrawBuffer[i] = {character, FG_NONE, 0};
 
-        color_set(nColor, NULL);
+      pDrawColors[i] = {foreground, background};
+    } else
+      pDrawBuffer[i] = {character, NearestColor(foreground), 0};
 
-        move(0, 0);
+    MarkDrawn();
+  }
 
-        for (int pixel = 0; pixel < nScreenWidth * nScreenHeight; pixel++) {
+  template <typename T> static T *AllocateCells(int nCells) {
 
-          if (nColor != nScreenBufferColors[pixel]) {
+    return static_cast<T *>(::operator new[](
+        nCells * sizeof(T), std::align_val_t(nCellAlignment)));
+  }
 
-            nColor = nScreenBufferColors[pixel];
-            color_set(nColor, NULL);
-          }
+  template <typename T> static void FreeCells(T *&pCells) {
 
-          printw("%lc", nScreenBufferCharacters[pixel]);
-        }
+    if (nullptr != pCells)
+      ::operator delete[](pCells, std::align_val_t(nCellAlignment));
 
-        int nKey;
+    pCells = nullptr;
+  }
 
-        mEvent = {};
+  // rows start every nRowStride cells, the width rounded up to whole cache
+  // lines, so every row is aligned for wide loads and stores
+  void AllocateScreenBuffers() {
 
-        if (bShowFPS) {
-          color_set(FG_GREEN, NULL);
-          mvprintw(nScreenHeight - 1, 0, "FPS: %10d",
-                   (int)(1.0f / fElapsedTime));
-        }
+    nRowStride = (nScreenWidth + nRowAlignment - 1) / nRowAlignment *
+                 nRowAlignment;
 
-        while ((nKey = getch()) != ERR)
-          if (nKey == KEY_MOUSE)
-            getmouse(&mEvent);
-          else if (nKey == KEY_RESIZE) {
+    int nCells = nRowStride * nScreenHeight;
 
-            getmaxyx(stdscr, nScreenHeight, nScreenWidth);
+    pScreenBuffer = AllocateCells<cb::Cell>(nCells);
 
-            delete nScreenBufferColors;
-            nScreenBufferColors =
-                new short[nScreenWidth * nScreenHeight]{FG_BLACK};
+    std::fill_n(pScreenBuffer, nCells, cb::Cell{PIXEL_FULL, FG_BLACK, 0});
 
-            delete nScreenBufferCharacters;
-            nScreenBufferCharacters =
-                new wchar_t[nScreenWidth * nScreenHeight]{PIXEL_FULL};
+    pFrontBuffer = AllocateCells<cb::Cell>(nCells);
 
-            m_bAtomActive = OnUserResize();
-          }
+    if (bTrueColor) {
 
-        sStartTimespec = sStopTimespec;
-      }
+      pScreenColors = AllocateCells<cb::CellColors>(nCells);
+
+      std::fill_n(pScreenColors, nCells,
+                  cb::CellColors{nPalette[FG_BLACK], nPalette[FG_BLACK]});
+
+      pFrontColors = AllocateCells<cb::CellColors>(nCells);
+
+      std::fill_n(pFrontColors, nCells, cb::CellColors{0, 0});
     }
-  }
 
-  int nScreenWidth;
+    if (bPipelined) {
 
-  int nScreenHeight;
+      pPendingBuffer = AllocateCells<cb::Cell>(nCells);
 
-  Display *XDisplay;
+      if (bTrueColor)
+        pPendingColors = AllocateCells<cb::CellColors>(nCells);
+    }
 
-  Window nWindowID;
+    // the output thread presents the pending copy of the screen buffers
+    pPresentBuffer = bPipelined ? pPendingBuffer : pScreenBuffer;
 
-  int nColors;
+    pPresentColors = bPipelined ? pPendingColors : pScreenColors;
 
-  short *nScreenBufferColors;
+    InvalidateFrontBuffer(0, 0, nCells);
 
-  wchar_t *nScreenBufferCharacters;
+    if (bLayered)
+      AllocateLayers();
 
-  KeyMap kmKeys{};
+    SelectDrawBuffers();
 
-  KeyMap kmKeysPrevious{};
+    if (bBinned) {
 
-  MEVENT mEvent{};
+      nTilesX = (nScreenWidth + nTileWidth - 1) / nTileWidth;
 
-  std::thread loop;
+      nTilesY = (nScreenHeight + nTileHeight - 1) / nTileHeight;
 
-  std::thread focus;
+      vBins.resize(nTilesX * nTilesY);
+    }
+  }
+
+  // layers start out transparent and are redrawn by the game, after a resize
+  // from OnUserResize
+  void AllocateLayers() {
+
+    int nCells = nRowStride * nScreenHeight;
+
+    for (auto &layer : aLayers) {
+
+      layer.pCells = AllocateCells<cb::Cell>(nCells);
+
+      std::fill_n(layer.pCells, nCells, cb::Cell{PIXEL_TRANSPARENT, FG_NONE, 0});
+
+      if (bTrueColor) {
+
+        layer.pColors = AllocateCells<cb::CellColors>(nCells);
+
+        std::fill_n(layer.pColors, nCells, cb::CellColors{0, 0});
+      }
+
+      layer.bDirty = true;
+    }
+  }
+
+  // drawing goes to the selected layer, or straight to the screen
+  inline void SelectDrawBuffers() {
+
+    if (bLayered) {
+
+      pDrawBuffer = aLayers[nLayer].pCells;
+
+      pDrawColors = aLayers[nLayer].pColors;
+
+      pDrawDirty = &aLayers[nLayer].bDirty;
+    } else {
+
+      pDrawBuffer = pScreenBuffer;
+
+      pDrawColors = pScreenColors;
+
+      pDrawDirty = nullptr;
+    }
+  }
+
+  // the screen itself is presented every frame, only layers keep a flag
+  inline void MarkDrawn() {
+
+    if (nullptr != pDrawDirty)
+      *pDrawDirty = true;
+  }
+
+  void FreeScreenBuffers() {
+
+    FreeCells(pScreenBuffer);
+
+    FreeCells(pFrontBuffer);
+
+    FreeCells(pPendingBuffer);
+
+    FreeCells(pScreenColors);
+
+    FreeCells(pFrontColors);
+
+    FreeCells(pPendingColors);
+
+    for (auto &layer : aLayers) {
+
+      FreeCells(layer.pCells);
+
+      FreeCells(layer.pColors);
+    }
+  }
+
+  // marks cells of the front buffer as unknown so they are re-emitted, the
+  // sentinel is never drawn by the game
+  inline void InvalidateFrontBuffer(int x, int y, int nCells) {
+
+    std::fill_n(pFrontBuffer + x + y * nRowStride,
+                std::min(nCells, nRowStride * (nScreenHeight - y) - x),
+                cb::Cell{L'\0', FG_NONE, 0});
+  }
+
+  // in truecolor mode the RGB colors are compared next to the cells
+  inline bool BuffersEqual(int i, int n) const {
+
+    if (0 != memcmp(pPresentBuffer + i, pFrontBuffer + i, n * sizeof(cb::Cell)))
+      return false;
+
+    return !bTrueColor || 0 == memcmp(pPresentColors + i, pFrontColors + i,
+                                      n * sizeof(cb::CellColors));
+  }
+
+  // calls fRun(y, x0, x1) for every run [x0, x1) of console cells that differ
+  // between the back and the front buffer, a cell spans nPixelRows rows of the
+  // buffers; rows are compared in blocks of nDiffBlockSize cells and runs
+  // separated by fewer than nDiffRunGap unchanged cells are merged as a
+  // cursor move costs more than re-emitting
+  template <typename F> void ForEachChangedRun(F fRun) {
+
+    for (int y = 0; y < nConsoleHeight; y++) {
+
+      int nRow = y * nPixelRows * nRowStride;
+
+      auto BlockEqual = [&](int x, int n) {
+        for (int k = 0; k < nPixelRows; k++)
+          if (!BuffersEqual(nRow + k * nRowStride + x, n))
+            return false;
+        return true;
+      };
+
+      if (BlockEqual(0, nScreenWidth))
+        continue;
+
+      int nRunStart = -1;
+
+      int nRunEnd = -1;
+
+      for (int x0 = 0; x0 < nScreenWidth; x0 += nDiffBlockSize) {
+
+        int nBlock = std::min(nDiffBlockSize, nScreenWidth - x0);
+
+        if (BlockEqual(x0, nBlock))
+          continue;
+
+        for (int x = x0; x < x0 + nBlock; x++) {
+
+          if (BlockEqual(x, 1))
+            continue;
+
+          nPresentChangedCells++;
+
+          if (nRunStart >= 0 && x - nRunEnd >= nDiffRunGap) {
+
+            fRun(y, nRunStart, nRunEnd);
+
+            nRunStart = -1;
+          }
+
+          if (nRunStart < 0)
+            nRunStart = x;
+
+          nRunEnd = x + 1;
+        }
+      }
+
+      if (nRunStart >= 0)
+        fRun(y, nRunStart, nRunEnd);
+    }
+  }
+
+  // copies a presented run of console cells to the front buffer
+  inline void CommitRun(int y, int x0, int x1) {
+
+    for (int k = 0; k < nPixelRows; k++) {
+
+      int nOffset = x0 + (y * nPixelRows + k) * nRowStride;
+
+      int nLength = x1 - x0;
+
+      std::copy_n(pPresentBuffer + nOffset, nLength, pFrontBuffer + nOffset);
+
+      if (bTrueColor)
+        std::copy_n(pPresentColors + nOffset, nLength, pFrontColors + nOffset);
+    }
+  }
+
+  // the spans of a filled circle, as drawn by the midpoint algorithm
+  template <typename F>
+  static void CircleSpans(int xc, int yc, int r, F fSpan) {
+
+    int x = 0;
+    int y = r;
+    int d = 3 - (2 * r);
+
+    auto Bresenham = [&fSpan](int xc, int yc, int x, int y) {
+      fSpan(xc - x, xc + x, yc - y);
+      fSpan(xc - y, xc + y, yc - x);
+      fSpan(xc - x, xc + x, yc + y);
+      fSpan(xc - y, xc + y, yc + x);
+    };
+
+    Bresenham(xc, yc, x, y);
+    while (x <= y) {
+      if (d <= 0)
+        d = d + (4 * x++) + 6;
+      else
+        d = d + (4 * x++) - (4 * y--) + 10;
+      Bresenham(xc, yc, x, y);
+    }
+  }
+
+  // copies the cells [nLeft, nRight] x [nTop, nBottom] of sprite s drawn with
+  // its top left at (x0, y0), which are on the screen and the sprite; rows of
+  // an opaque sprite at once, otherwise the runs of pixels that are drawn
+  void BlitSprite(const cb::Sprite &s, int x0, int y0, int nLeft, int nTop,
+                  int nRight, int nBottom) {
+
+    for (int y = nTop; y <= nBottom; y++) {
+
+      int nSpriteRow = y - y0;
+
+      const cb::Pixel *pRow = s.Pixels() + nSpriteRow * s.SpriteWidth() - x0;
+
+      if (s.IsOpaque()) {
+
+        CopyPixels(nLeft + y * nRowStride, pRow + nLeft, nRight - nLeft + 1);
+
+        continue;
+      }
+
+      for (const auto *pRun = s.RowRunsBegin(nSpriteRow);
+           pRun != s.RowRunsEnd(nSpriteRow) && pRun->nBegin + x0 <= nRight;
+           pRun++) {
+
+        int a = std::max(pRun->nBegin + x0, nLeft);
+
+        int b = std::min(pRun->nEnd + x0 - 1, nRight);
+
+        if (a <= b)
+          CopyPixels(a + y * nRowStride, pRow + a, b - a + 1);
+      }
+    }
+  }
+
+  // pixels are laid out as cells, with the attributes zero
+  inline void CopyPixels(int i, const cb::Pixel *pPixels, int nCount) {
+
+    memcpy(pDrawBuffer + i, pPixels, nCount * sizeof(cb::Cell));
+
+    if (bTrueColor)
+      for (int n = 0; n < nCount; n++)
+        pDrawColors[i + n] = {PaletteColor(pPixels[n].color),
+                              nPalette[FG_BLACK]};
+  }
+
+  // the Bresenham steps of DrawLine from pixel (x, y) with error term err on,
+  // for nPixels pixels, all of which are on the screen
+  inline void StepLine(int x, int y, int dx, int dy, int sx, int sy, int err,
+                       int nPixels, wchar_t character, short color) {
+
+    if (nullptr == pDrawTarget) {
+
+      FlushDrawCommands();
+
+      MarkDrawn();
+    }
+
+    for (int n = 0; n < nPixels; n++) {
+
+      if (nullptr != pDrawTarget)
+        pDrawTarget->Set(x, y, color);
+      else
+        PutCell(x + y * nRowStride, character, color);
+
+      int e2 = 2 * err;
+
+      if (e2 >= dy) {
+        err += dy;
+        x += sx;
+      }
+
+      if (e2 <= dx) {
+        err += dx;
+        y += sy;
+      }
+    }
+  }
+
+  // finds the first pixel of a line inside a nWidth by nHeight screen, the
+  // error term of DrawLine there and the number of pixels until the line
+  // leaves the screen. Every step of DrawLine advances the major axis, and
+  // after i steps it is floor((2 i m + M) / 2 M) steps along the minor one,
+  // for M and m the lengths along the major and minor axes. The error term
+  // only depends on the number of steps taken along each axis. This gives
+  // the range of steps on the screen in integer arithmetic, and the pixels
+  // from there on are exactly those of the whole line.
+  static bool ClipLine(int x1, int y1, int x2, int y2, int nWidth, int nHeight,
+                       int &x, int &y, int &err, int &nPixels) {
+
+    if (nWidth <= 0 || nHeight <= 0)
+      return false;
+
+    int64_t dx = std::abs(static_cast<int64_t>(x2) - x1);
+
+    int64_t dy = std::abs(static_cast<int64_t>(y2) - y1);
+
+    int sx = (x1 < x2) ? 1 : -1;
+
+    int sy = (y1 < y2) ? 1 : -1;
+
+    bool bMajorX = dx >= dy;
+
+    int64_t nMajor = bMajorX ? dx : dy, nMinor = bMajorX ? dy : dx;
+
+    auto FloorDiv = [](int64_t a, int64_t b) {
+      return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    };
+
+    // the steps that keep a coordinate starting at c within [0, nSize)
+    auto Steps = [](int64_t c, int s, int nSize, int64_t &a, int64_t &b) {
+      a = s > 0 ? -c : c - (nSize - 1);
+      b = s > 0 ? nSize - 1 - c : c;
+    };
+
+    int64_t i0, i1, j0, j1;
+
+    Steps(bMajorX ? x1 : y1, bMajorX ? sx : sy, bMajorX ? nWidth : nHeight, i0,
+          i1);
+
+    Steps(bMajorX ? y1 : x1, bMajorX ? sy : sx, bMajorX ? nHeight : nWidth, j0,
+          j1);
+
+    i0 = std::max<int64_t>(i0, 0);
+
+    i1 = std::min(i1, nMajor);
+
+    if (0 == nMinor) {
+
+      if (j0 > 0 || j1 < 0)
+        return false;
+    } else {
+
+      // the first step at least j0 and the last at most j1 along the minor axis
+      i0 = std::max(i0, -FloorDiv(nMajor - 2 * nMajor * j0, 2 * nMinor));
+
+      i1 = std::min(i1,
+                    -FloorDiv(nMajor - 2 * nMajor * (j1 + 1), 2 * nMinor) - 1);
+    }
+
+    if (i0 > i1)
+      return false;
+
+    int64_t j = 0 == nMajor ? 0 : FloorDiv(2 * i0 * nMinor + nMajor, 2 * nMajor);
+
+    int64_t nStepsX = bMajorX ? i0 : j, nStepsY = bMajorX ? j : i0;
+
+    x = static_cast<int>(x1 + sx * nStepsX);
+
+    y = static_cast<int>(y1 + sy * nStepsY);
+
+    err = static_cast<int>(dx - dy - nStepsX * dy + nStepsY * dx);
+
+    nPixels = static_cast<int>(i1 - i0 + 1);
+
+    return true;
+  }
+
+  // the ends a and b of row y of a triangle with its corners sorted on y, the
+  // same as stepping the edges down from the top; any row can be asked for,
+  // so a tile only walks the rows it covers
+  static inline void TriangleSpan(int x1, int y1, int x2, int y2, int x3,
+                                  int y3, int y, int &a, int &b) {
+
+    if (y1 == y3) {
+
+      a = std::min({x1, x2, x3});
+      b = std::max({x1, x2, x3});
+      return;
+    }
+
+    auto Edge = [y](int xa, int ya, int xb, int yb) {
+      return xa + static_cast<int>(static_cast<int64_t>(xb - xa) * (y - ya) /
+                                   (yb - ya));
+    };
+
+    a = (y < y2 || (y2 == y3 && y == y2)) ? Edge(x1, y1, x2, y2)
+                                          : Edge(x2, y2, x3, y3);
+
+    b = Edge(x1, y1, x3, y3);
+  }
+
+  // in MODE_BINNED the filled primitives are recorded instead of drawn,
+  // unless they go to a Braille canvas
+  inline bool Recording() const { return bBinned && nullptr == pDrawTarget; }
+
+  // adds a command to the bin of every tile its bounding box overlaps
+  void RecordDrawCommand(const DrawCommand &command) {
+
+    int x0 = std::max(command.nLeft, 0);
+
+    int x1 = std::min(command.nRight, nScreenWidth - 1);
+
+    int y0 = std::max(command.nTop, 0);
+
+    int y1 = std::min(command.nBottom, nScreenHeight - 1);
+
+    if (x0 > x1 || y0 > y1)
+      return;
+
+    auto n = static_cast<uint32_t>(vDrawCommands.size());
+
+    vDrawCommands.emplace_back(command);
+
+    for (int ty = y0 / nTileHeight; ty <= y1 / nTileHeight; ty++)
+      for (int tx = x0 / nTileWidth; tx <= x1 / nTileWidth; tx++)
+        vBins[tx + ty * nTilesX].emplace_back(n);
+
+    MarkDrawn();
+  }
+
+  // rasterizes the recorded commands before anything is drawn over them on
+  // every thread of the job system; each tile is rasterized by a single
+  // thread, in the order its commands were recorded
+  void FlushDrawCommands() {
+
+    if (vDrawCommands.empty())
+      return;
+
+    nNextTile.store(0, std::memory_order_relaxed);
+
+    cb::TaskGroup group;
+
+    for (unsigned i = 1; i < jobs.Threads(); i++)
+      jobs.Run(group, [this] { RasterizeTiles(); });
+
+    RasterizeTiles();
+
+    jobs.Wait(group);
+
+    vDrawCommands.clear();
+
+    for (auto &vBin : vBins)
+      vBin.clear();
+  }
+
+  // takes tiles until none are left
+  void RasterizeTiles() {
+
+    for (int nTile = nNextTile.fetch_add(1, std::memory_order_relaxed);
+         nTile < nTilesX * nTilesY;
+         nTile = nNextTile.fetch_add(1, std::memory_order_relaxed))
+      if (!vBins[nTile].empty())
+        RasterizeTile(nTile);
+  }
+
+  void RasterizeTile(int nTile) {
+
+    int tx0 = nTile % nTilesX * nTileWidth;
+
+    int ty0 = nTile / nTilesX * nTileHeight;
+
+    int tx1 = std::min(tx0 + nTileWidth, nScreenWidth) - 1;
+
+    int ty1 = std::min(ty0 + nTileHeight, nScreenHeight) - 1;
+
+    for (uint32_t n : vBins[nTile]) {
+
+      const DrawCommand &c = vDrawCommands[n];
+
+      int x0 = std::max(tx0, c.nLeft), x1 = std::min(tx1, c.nRight);
+
+      int y0 = std::max(ty0, c.nTop), y1 = std::min(ty1, c.nBottom);
+
+      auto Span = [&](int a, int b, int y) {
+        if (y < y0 || y > y1)
+          return;
+
+        if (a > b)
+          std::swap(a, b);
+
+        a = std::max(a, x0);
+
+        b = std::min(b, x1);
+
+        if (a <= b)
+          PutSpan(a + y * nRowStride, b - a + 1, c.character, c.color);
+      };
+
+      switch (c.nType) {
+
+      case COMMAND_RECTANGLE:
+        for (int y = y0; y <= y1; y++)
+          Span(x0, x1, y);
+        break;
+
+      case COMMAND_TRIANGLE:
+        for (int y = y0; y <= y1; y++) {
+
+          int a, b;
+
+          TriangleSpan(c.x1, c.y1, c.x2, c.y2, c.x3, c.y3, y, a, b);
+
+          Span(a, b, y);
+        }
+        break;
+
+      case COMMAND_CIRCLE:
+        CircleSpans(c.x1, c.y1, c.x2, Span);
+        break;
+
+      case COMMAND_SPRITE:
+        BlitSprite(*c.pSprite, c.x1 - c.x2, c.y1 - c.y2, x0, y0, x1, y1);
+        break;
+      }
+    }
+  }
+
+  // converts the dots of the canvases drawn this frame to Braille glyphs,
+  // cells without dots leave the screen untouched
+  void ComposeCanvases() {
+
+    bCanvasesComposed = !vCanvases.empty();
+
+    pDrawBuffer = pScreenBuffer;
+
+    pDrawColors = pScreenColors;
+
+    pDrawDirty = nullptr;
+
+    for (auto *canvas : vCanvases) {
+
+      for (int cy = 0; cy < canvas->CellHeight(); cy++) {
+
+        int y = canvas->CellY() + cy;
+
+        if (y < 0 || y >= nConsoleHeight)
+          continue;
+
+        for (int cx = 0; cx < canvas->CellWidth(); cx++) {
+
+          int x = canvas->CellX() + cx;
+
+          int i = cx + cy * canvas->CellWidth();
+
+          if (x < 0 || x >= nScreenWidth || 0 == canvas->Mask(i))
+            continue;
+
+          SetCell(x + y * nPixelRows * nRowStride, canvas->Glyph(i),
+                  canvas->Color(i));
+        }
+      }
+    }
+
+    vCanvases.clear();
+
+    pDrawTarget = nullptr;
+
+    SelectDrawBuffers();
+  }
+
+  // rebuilds the screen from the layers, every cell showing the topmost one
+  // that is not transparent, when a layer was drawn to or canvases were
+  // composited over the previous frame; otherwise the screen still holds the
+  // previous composite
+  void ComposeLayers() {
+
+    if (!bLayered)
+      return;
+
+    bool bDirty = bCanvasesComposed;
+
+    for (auto &layer : aLayers) {
+
+      bDirty |= layer.bDirty;
+
+      layer.bDirty = false;
+    }
+
+    if (!bDirty)
+      return;
+
+    int nCells = nRowStride * nScreenHeight;
+
+    for (int i = 0; i < nCells; i++) {
+
+      int k = LAYER_COUNT - 1;
+
+      while (k >= 0 && PIXEL_TRANSPARENT == aLayers[k].pCells[i].character)
+        k--;
+
+      if (k < 0) {
+
+        pScreenBuffer[i] = {PIXEL_FULL, FG_BLACK, 0};
+
+        if (bTrueColor)
+          pScreenColors[i] = {nPalette[FG_BLACK], nPalette[FG_BLACK]};
+
+        continue;
+      }
+
+      pScreenBuffer[i] = aLayers[k].pCells[i];
+
+      if (bTrueColor)
+        pScreenColors[i] = aLayers[k].pColors[i];
+    }
+  }
+
+  void Present(float fElapsedTime) {
+
+    auto tpStart = std::chrono::steady_clock::now();
+
+    nPresentChangedCells = 0;
+
+    nPresentColorSwitches = 0;
+
+    nPresentBytesSaved = 0;
+
+    if (OUTPUT_NCURSES != nOutput) {
+
+      sFrame.clear();
+
+      nRepeatGlyph = L'\0';
+
+      PresentANSI();
+
+      FlushRepeats();
+
+      if (bShowFPS && OUTPUT_ANSI == nOutput) {
+        AppendCursor(nConsoleHeight - 1, 0);
+        AppendColor(FG_GREEN);
+        char cFPS[16];
+        sFrame.append(cFPS, snprintf(cFPS, sizeof(cFPS), "FPS: %10d",
+                                     (int)(1.0f / fElapsedTime)));
+      }
+
+      nFrameBytes = sFrame.size();
+
+      if (OUTPUT_ANSI == nOutput)
+        WriteFrame();
+    } else {
+
+      PresentNCurses();
+
+      if (bShowFPS) {
+        color_set(FG_GREEN, NULL);
+        mvprintw(nConsoleHeight - 1, 0, "FPS: %10d",
+                 (int)(1.0f / fElapsedTime));
+      }
+
+      // input is read by InputThread, so no getch() refreshes the screen
+      refresh();
+    }
+
+    if (bShowFPS && OUTPUT_HEADLESS != nOutput)
+      for (int k = 1; k <= nPixelRows; k++)
+        InvalidateFrontBuffer(0, nScreenHeight - k, 15);
+
+    fPresentTime = std::chrono::duration<float, std::milli>(
+                       std::chrono::steady_clock::now() - tpStart)
+                       .count();
+  }
+
+  void WriteFrame() {
+
+    for (size_t nWritten = 0; nWritten < sFrame.size();) {
+
+      ssize_t n = write(STDOUT_FILENO, sFrame.data() + nWritten,
+                        sFrame.size() - nWritten);
+
+      if (n < 0 && errno != EINTR && errno != EAGAIN)
+        break;
+
+      if (n > 0)
+        nWritten += n;
+    }
+  }
+
+  void PresentNCurses() {
+
+    short nColor = -1;
+
+    ForEachChangedRun([this, &nColor](int y, int x0, int x1) {
+      int nOffset = x0 + y * nRowStride;
+
+      int nLength = x1 - x0;
+
+      move(y, x0);
+
+      for (int pixel = nOffset; pixel < nOffset + nLength;) {
+
+        if (nColor != pPresentBuffer[pixel].color) {
+
+          nColor = pPresentBuffer[pixel].color;
+          color_set(nColor, NULL);
+          nPresentColorSwitches++;
+        }
+
+        wsRun.clear();
+
+        int nSpan = 0;
+
+        do
+          wsRun.push_back(pPresentBuffer[pixel + nSpan++].character);
+        while (pixel + nSpan < nOffset + nLength &&
+               pPresentBuffer[pixel + nSpan].color == nColor);
+
+        printw("%ls", wsRun.c_str());
+
+        pixel += nSpan;
+      }
+
+      CommitRun(y, x0, x1);
+    });
+  }
+
+  void PresentANSI() {
+
+    if (2 == nPixelRows) {
+
+      PresentHalfBlock();
+
+      return;
+    }
+
+    if (bTrueColor) {
+
+      PresentTrueColor();
+
+      return;
+    }
+
+    short nColor = -1;
+
+    ForEachChangedRun([this, &nColor](int y, int x0, int x1) {
+      int nOffset = x0 + y * nRowStride;
+
+      AppendCursor(y, x0);
+
+      for (int pixel = nOffset; pixel < nOffset + x1 - x0; pixel++) {
+
+        if (nColor != pPresentBuffer[pixel].color) {
+
+          nColor = pPresentBuffer[pixel].color;
+          AppendColor(nColor);
+        }
+
+        AppendCell(pPresentBuffer[pixel].character);
+      }
+
+      CommitRun(y, x0, x1);
+    });
+  }
+
+  void PresentTrueColor() {
+
+    uint32_t nForeground = UINT32_MAX, nBackground = UINT32_MAX;
+
+    ForEachChangedRun([&](int y, int x0, int x1) {
+      int nOffset = x0 + y * nRowStride;
+
+      AppendCursor(y, x0);
+
+      for (int pixel = nOffset; pixel < nOffset + x1 - x0; pixel++) {
+
+        AppendColors(nForeground, nBackground,
+                     pPresentColors[pixel].foreground,
+                     pPresentColors[pixel].background);
+
+        AppendCell(pPresentBuffer[pixel].character);
+      }
+
+      CommitRun(y, x0, x1);
+    });
+  }
+
+  // every console cell shows two pixels of the buffer: the upper one as the
+  // foreground of an upper half block and the lower one as its background;
+  // a cell with text in either pixel shows that glyph instead
+  void PresentHalfBlock() {
+
+    uint32_t nForeground = UINT32_MAX, nBackground = UINT32_MAX;
+
+    ForEachChangedRun([&](int y, int x0, int x1) {
+      AppendCursor(y, x0);
+
+      for (int x = x0; x < x1; x++) {
+
+        int nTop = x + 2 * y * nRowStride;
+
+        int nBottom = nTop + nRowStride;
+
+        uint32_t nTopColor = PixelColor(nTop);
+
+        uint32_t nBottomColor = PixelColor(nBottom);
+
+        wchar_t character = PIXEL_UPPER;
+
+        if (!IsPixel(pPresentBuffer[nTop].character)) {
+
+          character = pPresentBuffer[nTop].character;
+
+          if (!IsPixel(pPresentBuffer[nBottom].character))
+            nBottomColor = bTrueColor ? nPalette[FG_BLACK]
+                                      : static_cast<uint32_t>(FG_BLACK);
+        } else if (!IsPixel(pPresentBuffer[nBottom].character)) {
+
+          character = pPresentBuffer[nBottom].character;
+
+          std::swap(nTopColor, nBottomColor);
+        } else if (nTopColor == nBottomColor) {
+
+          // a uniform cell needs no color change when either matches
+          if (nTopColor == nForeground) {
+            AppendCell(PIXEL_FULL);
+            continue;
+          }
+
+          if (nTopColor == nBackground) {
+            AppendCell(L' ');
+            continue;
+          }
+        }
+
+        AppendColors(nForeground, nBackground, nTopColor, nBottomColor);
+
+        AppendCell(character);
+      }
+
+      CommitRun(y, x0, x1);
+    });
+  }
+
+  static inline bool IsPixel(wchar_t character) {
+
+    return PIXEL_FULL == character || PIXEL_LIGHT == character ||
+           PIXEL_MEDIUM == character || PIXEL_DARK == character ||
+           L' ' == character;
+  }
+
+  // the color a pixel shows, an RGB value in truecolor mode and a palette
+  // index otherwise; blanks show the background
+  inline uint32_t PixelColor(int i) const {
+
+    if (bTrueColor)
+      return L' ' == pPresentBuffer[i].character ? pPresentColors[i].background
+                                                 : pPresentColors[i].foreground;
+
+    return L' ' == pPresentBuffer[i].character
+               ? static_cast<uint32_t>(FG_BLACK)
+               : static_cast<uint32_t>(pPresentBuffer[i].color);
+  }
+
+  // emits a single SGR sequence for whichever of the foreground and
+  // background differ from the current ones; colors are RGB values in
+  // truecolor mode and palette indices otherwise
+  inline void AppendColors(uint32_t &nForeground, uint32_t &nBackground,
+                           uint32_t foreground, uint32_t background) {
+
+    bool bForeground = nForeground != foreground;
+
+    bool bBackground = nBackground != background;
+
+    if (!bForeground && !bBackground)
+      return;
+
+    BreakRepeats();
+
+    nPresentColorSwitches++;
+
+    sFrame.append("\x1b[", 2);
+
+    if (bForeground) {
+
+      nForeground = foreground;
+
+      if (bTrueColor) {
+        sFrame.append("38;2;", 5);
+        AppendTrueColor(foreground);
+      } else if (foreground <= FG_NONE || foreground > (uint32_t)nColors)
+        sFrame.append("39", 2);
+      else {
+        sFrame.append("38;5;", 5);
+        AppendNumber(foreground - 1);
+      }
+    }
+
+    if (bBackground) {
+
+      nBackground = background;
+
+      if (bForeground)
+        sFrame.push_back(';');
+
+      if (bTrueColor) {
+        sFrame.append("48;2;", 5);
+        AppendTrueColor(background);
+      } else if (background <= FG_NONE || background > (uint32_t)nColors)
+        sFrame.append("49", 2);
+      else {
+        sFrame.append("48;5;", 5);
+        AppendNumber(background - 1);
+      }
+    }
+
+    sFrame.push_back('m');
+  }
+
+  inline void AppendTrueColor(uint32_t color) {
+
+    AppendNumber((color >> 16) & 0xFF);
+    sFrame.push_back(';');
+    AppendNumber((color >> 8) & 0xFF);
+    sFrame.push_back(';');
+    AppendNumber(color & 0xFF);
+  }
+
+  inline void AppendNumber(unsigned n) {
+
+    char cDigits[10];
+
+    int i = 0;
+
+    do {
+      cDigits[i++] = static_cast<char>('0' + n % 10);
+      n /= 10;
+    } while (n > 0);
+
+    while (i > 0)
+      sFrame.push_back(cDigits[--i]);
+  }
+
+  inline void AppendCursor(int y, int x) {
+
+    BreakRepeats();
+
+    nCursorColumn = x;
+
+    sFrame.append("\x1b[", 2);
+    AppendNumber(y + 1);
+    sFrame.push_back(';');
+    AppendNumber(x + 1);
+    sFrame.push_back('H');
+  }
+
+  // color pair n has foreground n - 1 on black, pair 0 the default colors
+  inline void AppendColor(short color) {
+
+    BreakRepeats();
+
+    nPresentColorSwitches++;
+
+    if (color <= FG_NONE || color > nColors) {
+      sFrame.append("\x1b[39;49m", 8);
+      return;
+    }
+
+    sFrame.append("\x1b[38;5;", 7);
+    AppendNumber(color - 1);
+    sFrame.append(";48;5;0m", 8);
+  }
+
+  // a glyph equal to the one before it is held back, so that a run of them
+  // can be emitted at once by FlushRepeats(); the cursor column is only
+  // advanced after a run is flushed, so that it tells where the run ends
+  inline void AppendCell(wchar_t character) {
+
+    if (character == nRepeatGlyph && (bRepeatGlyphs || bEraseLines)) {
+      nRepeatCount++;
+      nCursorColumn++;
+      return;
+    }
+
+    FlushRepeats();
+
+    nCursorColumn++;
+
+    size_t nSize = sFrame.size();
+
+    AppendGlyph(character);
+
+    nRepeatGlyph = character;
+
+    nRepeatGlyphBytes = sFrame.size() - nSize;
+  }
+
+  // blanks that reach the end of the line, with the cursor right after the
+  // run, are erased with the background color, other runs are repeated with REP, whichever is shorter than
+  // writing the glyphs out
+  inline void FlushRepeats() {
+
+    if (0 == nRepeatCount)
+      return;
+
+    size_t nPlain = nRepeatCount * nRepeatGlyphBytes;
+
+    size_t nRepeat = 3 + (nRepeatCount < 10     ? 1
+                          : nRepeatCount < 100  ? 2
+                          : nRepeatCount < 1000 ? 3
+                                                : 4);
+
+    if (bEraseLines && L' ' == nRepeatGlyph && nCursorColumn >= nScreenWidth &&
+        nPlain > 3) {
+
+      sFrame.append("\x1b[K", 3);
+
+      nPresentBytesSaved += nPlain - 3;
+    } else if (bRepeatGlyphs && nPlain > nRepeat) {
+
+      sFrame.append("\x1b[", 2);
+      AppendNumber(nRepeatCount);
+      sFrame.push_back('b');
+
+      nPresentBytesSaved += nPlain - nRepeat;
+    } else
+      for (size_t i = 0; i < nRepeatCount; i++)
+        AppendGlyph(nRepeatGlyph);
+
+    nRepeatCount = 0;
+  }
+
+  // REP is not relied upon across cursor moves or color changes
+  inline void BreakRepeats() {
+
+    FlushRepeats();
+
+    nRepeatGlyph = L'\0';
+  }
+
+  // UTF-8 encodings of the Basic Multilingual Plane are cached as they are
+  // first seen: the low three bytes hold the sequence, the top byte its length
+  inline void AppendGlyph(wchar_t character) {
+
+    auto c = static_cast<uint32_t>(character);
+
+    if (c < 0x80) {
+      sFrame.push_back(static_cast<char>(c));
+      return;
+    }
+
+    if (c > 0xFFFF) {
+      char cBytes[4] = {static_cast<char>(0xF0 | (c >> 18)),
+                        static_cast<char>(0x80 | ((c >> 12) & 0x3F)),
+                        static_cast<char>(0x80 | ((c >> 6) & 0x3F)),
+                        static_cast<char>(0x80 | (c & 0x3F))};
+      sFrame.append(cBytes, 4);
+      return;
+    }
+
+    if (vGlyphs.empty())
+      vGlyphs.resize(0x10000, 0);
+
+    uint32_t nEncoded = vGlyphs[c];
+
+    if (0 == nEncoded) {
+
+      if (c < 0x800)
+        nEncoded = (2u << 24) | ((0xC0 | (c >> 6)) << 0) |
+                   ((0x80 | (c & 0x3F)) << 8);
+      else
+        nEncoded = (3u << 24) | ((0xE0 | (c >> 12)) << 0) |
+                   ((0x80 | ((c >> 6) & 0x3F)) << 8) |
+                   ((0x80 | (c & 0x3F)) << 16);
+
+      vGlyphs[c] = nEncoded;
+    }
+
+    char cBytes[3] = {static_cast<char>(nEncoded & 0xFF),
+                      static_cast<char>((nEncoded >> 8) & 0xFF),
+                      static_cast<char>((nEncoded >> 16) & 0xFF)};
+
+    sFrame.append(cBytes, nEncoded >> 24);
+  }
+
+  // hands the finished frame to the output thread by swapping the screen and
+  // pending buffers, which only waits when the previous frame is still being
+  // written; the game keeps drawing on a copy of the frame it just finished
+  void SubmitFrame(float fElapsedTime) {
+
+    WaitForOutput();
+
+    SnapshotPresentMetrics();
+
+    std::swap(pScreenBuffer, pPendingBuffer);
+
+    std::swap(pScreenColors, pPendingColors);
+
+    pPresentBuffer = pPendingBuffer;
+
+    pPresentColors = pPendingColors;
+
+    int nCells = nRowStride * nScreenHeight;
+
+    std::copy_n(pPendingBuffer, nCells, pScreenBuffer);
+
+    if (bTrueColor)
+      std::copy_n(pPendingColors, nCells, pScreenColors);
+
+    SelectDrawBuffers();
+
+    fPendingElapsedTime = fElapsedTime;
+
+    SetPipelineState(1, bOutputParked);
+  }
+
+  void WaitForOutput() { AwaitPipelineState(1, bGameParked); }
+
+  [[maybe_unused]] void OutputThread() {
+
+    while (true) {
+
+      AwaitPipelineState(0, bOutputParked);
+
+      if (2 == nPipelineState.load(std::memory_order_acquire))
+        break;
+
+      Present(fPendingElapsedTime);
+
+      SetPipelineState(0, bGameParked);
+    }
+  }
+
+  void StopOutput() {
+
+    if (!output.joinable())
+      return;
+
+    WaitForOutput();
+
+    SetPipelineState(2, bOutputParked);
+
+    output.join();
+  }
+
+  // the handoff takes no lock: a waiting thread spins a while before it parks
+  // on the condition variable, and the lock is only taken to wake it then;
+  // both stores and loads are sequentially consistent, so either the setter
+  // sees the flag or the waiter sees the new state
+  void SetPipelineState(int nState, std::atomic<bool> &bParked) {
+
+    nPipelineState.store(nState);
+
+    if (bParked.load()) {
+
+      std::lock_guard<std::mutex> lock(mOutput);
+
+      cvOutput.notify_all();
+    }
+  }
+
+  // waits while the state is nState
+  void AwaitPipelineState(int nState, std::atomic<bool> &bParked) {
+
+    for (int i = 0; i < nPipelineSpins; i++) {
+
+      if (nState != nPipelineState.load(std::memory_order_acquire))
+        return;
+
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(mOutput);
+
+    bParked.store(true);
+
+    cvOutput.wait(lock, [this, nState] {
+      return nState != nPipelineState.load();
+    });
+
+    bParked.store(false);
+  }
+
+  // runs the fixed updates the elapsed time is due, at most nMaxFixedSteps
+  // so a slow frame does not snowball into ever more updates
+  bool FixedUpdate(float fElapsedTime) {
+
+    if (fFixedTimestep <= 0.0f)
+      return true;
+
+    fFixedAccumulator +=
+        std::min(fElapsedTime, nMaxFixedSteps * fFixedTimestep);
+
+    while (fFixedAccumulator >= fFixedTimestep) {
+
+      fFixedAccumulator -= fFixedTimestep;
+
+      if (!OnUserFixedUpdate(fFixedTimestep))
+        return false;
+    }
+
+    return true;
+  }
+
+  void WaitForNextFrame(std::chrono::steady_clock::time_point &tpNextFrame) {
+
+    if (fTargetFrameTime <= 0.0f || OUTPUT_HEADLESS == nOutput)
+      return;
+
+    tpNextFrame +=
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(fTargetFrameTime));
+
+    auto tpNow = std::chrono::steady_clock::now();
+
+    // a frame that ran late starts the schedule over instead of rushing the
+    // frames that follow
+    if (tpNextFrame <= tpNow) {
+      tpNextFrame = tpNow;
+      return;
+    }
+
+    auto dSpin = std::chrono::microseconds(nPacingSpinMicroseconds);
+
+    if (tpNextFrame - tpNow > dSpin)
+      std::this_thread::sleep_for(tpNextFrame - tpNow - dSpin);
+
+    while (std::chrono::steady_clock::now() < tpNextFrame)
+      std::this_thread::yield();
+  }
+
+  // copies the statistics of the frame presented last while no present is
+  // running, when pipelined they lag one frame behind
+  void SnapshotPresentMetrics() {
+
+    aPresentMetrics[METRIC_PRESENT_TIME] = fPresentTime;
+
+    aPresentMetrics[METRIC_BYTES] = static_cast<float>(nFrameBytes);
+
+    aPresentMetrics[METRIC_CHANGED_CELLS] =
+        static_cast<float>(nPresentChangedCells);
+
+    aPresentMetrics[METRIC_COLOR_SWITCHES] =
+        static_cast<float>(nPresentColorSwitches);
+
+    aPresentMetrics[METRIC_BYTES_SAVED] =
+        static_cast<float>(nPresentBytesSaved);
+  }
+
+  void RecordMetrics(float fUpdateTime, float fInputTime) {
+
+    auto &aFrame = aMetrics[nMetricsFrames++ % nMetricsWindow];
+
+    aFrame = aPresentMetrics;
+
+    aFrame[METRIC_UPDATE_TIME] = fUpdateTime;
+
+    aFrame[METRIC_INPUT_TIME] = fInputTime;
+
+    if (!pMetricsFile.empty())
+      vMetricsLog.emplace_back(aFrame);
+  }
+
+  // the key state and the events of the frame, from the script when headless
+  // and otherwise as queued by InputThread, or for keys without bKittyKeys
+  // from the keyboard
+  void ReadInput() {
+
+    memcpy(&kmKeysPrevious, &kmKeys, sizeof(kmKeys));
+
+    vEvents.clear();
+
+    nEventsPolled = 0;
+
+    if (OUTPUT_HEADLESS == nOutput) {
+      ReadScript();
+      return;
+    }
+
+    cb::InputEvent event;
+
+    bool bResized = false;
+
+    while (qEvents.Pop(event)) {
+
+      if (EVENT_KEY == event.nType && bKittyKeys)
+        KeyEvent(event.nKey, event.nAction);
+      else if (EVENT_MOUSE == event.nType) {
+
+        event.y *= nPixelRows;
+
+        // only the latest position of a drag or motion counts per frame
+        if ((REPORT_MOUSE_POSITION & event.nButtons) && !vEvents.empty() &&
+            EVENT_MOUSE == vEvents.back().nType &&
+            event.nButtons == vEvents.back().nButtons) {
+          vEvents.back() = event;
+          continue;
+        }
+      } else if (EVENT_RESIZE == event.nType)
+        bResized = true;
+      else if (EVENT_FOCUS == event.nType) {
+
+        m_bAtomFocused = 0 != event.nAction;
+
+        // releases would go to another window
+        if (!m_bAtomFocused)
+          memset(&kmKeysHeld, 0, sizeof(kmKeysHeld));
+      }
+
+      vEvents.emplace_back(event);
+    }
+
+    // a key struck since the last frame shows pressed for at least a frame,
+    // even when it was released before this one
+    if (bKittyKeys)
+      for (int i = 0; i < 4; i++) {
+
+        kmKeys[i].bigEndianValue =
+            kmKeysHeld[i].bigEndianValue | kmKeysStruck[i].bigEndianValue;
+
+        kmKeysStruck[i].bigEndianValue = 0;
+      }
+#ifdef __APPLE__
+    else
+      GetKeys(kmKeys);
+#endif
+
+    if (bResized)
+      ResizeConsole();
+  }
+
+  void ReadScript() {
+
+    cb::InputEvent event{};
+
+    event.tpTime = std::chrono::steady_clock::now();
+
+    for (; nScriptedKey < vScriptedKeys.size() &&
+           vScriptedKeys[nScriptedKey].nFrame <= nFrameCount;
+         nScriptedKey++) {
+
+      const ScriptedKey &sKey = vScriptedKeys[nScriptedKey];
+
+      if (sKey.bPressed)
+        kmKeys[sKey.nKey / 32].bigEndianValue |= (1 << (sKey.nKey % 32));
+      else
+        kmKeys[sKey.nKey / 32].bigEndianValue &= ~(1 << (sKey.nKey % 32));
+
+      event.nType = EVENT_KEY;
+
+      event.nAction = sKey.bPressed ? ACTION_PRESS : ACTION_RELEASE;
+
+      event.nKey = sKey.nKey;
+
+      vEvents.emplace_back(event);
+    }
+
+    for (; nScriptedMouse < vScriptedMice.size() &&
+           vScriptedMice[nScriptedMouse].first <= nFrameCount;
+         nScriptedMouse++)
+      if (vScriptedMice[nScriptedMouse].first == nFrameCount) {
+
+        const MEVENT &sEvent = vScriptedMice[nScriptedMouse].second;
+
+        event.nType = EVENT_MOUSE;
+
+        event.nButtons = sEvent.bstate;
+
+        event.x = sEvent.x;
+
+        event.y = sEvent.y * nPixelRows;
+
+        vEvents.emplace_back(event);
+      }
+  }
+
+  // the new size of the terminal, which ncurses is told as well
+  void ResizeConsole() {
+
+    WaitForOutput();
+
+    struct winsize sSize {};
+
+    if (0 == ioctl(STDOUT_FILENO, TIOCGWINSZ, &sSize) && sSize.ws_row > 0 &&
+        sSize.ws_col > 0)
+      resizeterm(sSize.ws_row, sSize.ws_col);
+
+    getmaxyx(stdscr, nConsoleHeight, nScreenWidth);
+
+    nScreenHeight = nConsoleHeight * nPixelRows;
+
+    FreeScreenBuffers();
+
+    AllocateScreenBuffers();
+
+    m_bAtomActive = OnUserResize();
+  }
+
+  // reads the terminal as input arrives and queues its events, until woken
+  // with cWakeStop
+  void InputThread() {
+
+    pollfd aDescriptors[2] = {{STDIN_FILENO, POLLIN, 0},
+                              {nWakePipe[0], POLLIN, 0}};
+
+    char aBuffer[256];
+
+    while (true) {
+
+      int nTimeout = -1;
+
+      if (bPendingClick)
+        nTimeout = static_cast<int>(std::max<long long>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(
+                   tpClickDeadline - std::chrono::steady_clock::now())
+                       .count() +
+                   1));
+
+      if (poll(aDescriptors, 2, nTimeout) < 0) {
+
+        if (EINTR == errno)
+          continue;
+
+        break;
+      }
+
+      tpRead = std::chrono::steady_clock::now();
+
+      if (bPendingClick && tpRead >= tpClickDeadline)
+        FlushClick();
+
+      if (aDescriptors[1].revents & POLLIN) {
+
+        ssize_t n = read(nWakePipe[0], aBuffer, sizeof(aBuffer));
+
+        bool bStop = false, bResize = false;
+
+        for (ssize_t k = 0; k < n; k++) {
+          bStop |= cWakeStop == aBuffer[k];
+          bResize |= cWakeResize == aBuffer[k];
+        }
+
+        if (bStop)
+          break;
+
+        if (bResize) {
+
+          cb::InputEvent event{};
+
+          event.nType = EVENT_RESIZE;
+
+          event.tpTime = tpRead;
+
+          PushEvent(event);
+        }
+      }
+
+      if (0 == aDescriptors[0].revents)
+        continue;
+
+      ssize_t n = read(STDIN_FILENO, aBuffer, sizeof(aBuffer));
+
+      if (n > 0) {
+
+        sInput.append(aBuffer, n);
+
+        ParseInput();
+      } else if (0 == n || (EINTR != errno && EAGAIN != errno))
+        aDescriptors[0].fd = -1;
+    }
+  }
+
+  static void OnWindowChange(int) {
+
+    int nErrno = errno;
+
+    WakeInputThread(cWakeResize);
+
+    errno = nErrno;
+  }
+
+  static void WakeInputThread(char cReason) {
+
+    if (nWakePipe[1] < 0)
+      return;
+
+    [[maybe_unused]] ssize_t n = write(nWakePipe[1], &cReason, 1);
+  }
+
+  // parses what InputThread read from the terminal: the mouse in the SGR and
+  // the legacy encoding, and keys as kitty keyboard protocol escape codes,
+  // CSI number ; modifiers:event final, or without it as legacy escape codes
+  // and characters, which only tell a key was struck
+  void ParseInput() {
+
+    size_t i = 0;
+
+    while (i < sInput.size()) {
+
+      if ('\x1b' != sInput[i]) {
+        PushKey(UnicodeKey(static_cast<unsigned char>(sInput[i++])), 0);
+        continue;
+      }
+
+      // a lone escape is the key itself
+      if (i + 1 == sInput.size()) {
+        PushKey(kVK_Escape, 0);
+        i++;
+        continue;
+      }
+
+      if ('O' == sInput[i + 1]) {
+
+        if (i + 2 == sInput.size())
+          break;
+
+        PushKey(FunctionKey(1, sInput[i + 2]), 0);
+
+        i += 3;
+
+        continue;
+      }
+
+      if ('[' != sInput[i + 1]) {
+        PushKey(kVK_Escape, 0);
+        i++;
+        continue;
+      }
+
+      // CSI M and three bytes of button and position plus 32
+      if (i + 2 < sInput.size() && 'M' == sInput[i + 2]) {
+
+        if (i + 6 > sInput.size())
+          break;
+
+        MouseEvent(static_cast<unsigned char>(sInput[i + 3]) - 32,
+                   static_cast<unsigned char>(sInput[i + 4]) - 33,
+                   static_cast<unsigned char>(sInput[i + 5]) - 33, false);
+
+        i += 6;
+
+        continue;
+      }
+
+      size_t j = i + 2;
+
+      while (j < sInput.size() && (sInput[j] < 0x40 || sInput[j] > 0x7e))
+        j++;
+
+      // the rest of the sequence arrives with the next read
+      if (j == sInput.size())
+        break;
+
+      ParseSequence(i + 2, j);
+
+      i = j + 1;
+    }
+
+    sInput.erase(0, i);
+
+    FlushMotion();
+
+    // not a sequence this engine sent for, so it will never complete
+    if (sInput.size() > 64)
+      sInput.clear();
+  }
+
+  // the parameters of the escape code in sInput[nBegin, nEnd) and its final
+  // byte at nEnd
+  void ParseSequence(size_t nBegin, size_t nEnd) {
+
+    char cFinal = sInput[nEnd];
+
+    char cPrivate = '\0';
+
+    if (nBegin < nEnd && (sInput[nBegin] < '0' || sInput[nBegin] > ';'))
+      cPrivate = sInput[nBegin++];
+
+    // the key code, and the event type in the second field, or the button
+    // and the position of the mouse
+    int nCode = 0, nEvent = 1, nField = 0, nSubField = 0;
+
+    int aMouse[3] = {0, 0, 0};
+
+    for (size_t k = nBegin; k < nEnd; k++) {
+
+      char c = sInput[k];
+
+      if (';' == c) {
+        nField++;
+        nSubField = 0;
+      } else if (':' == c)
+        nSubField++;
+      else if (c >= '0' && c <= '9') {
+        if (nField < 3 && 0 == nSubField)
+          aMouse[nField] = 10 * aMouse[nField] + (c - '0');
+
+        if (0 == nField && 0 == nSubField)
+          nCode = 10 * nCode + (c - '0');
+        else if (1 == nField && 1 == nSubField)
+          nEvent = c - '0';
+      }
+    }
+
+    // the reply to CSI ? u has the flags in effect, 2 being the event types
+    if ('?' == cPrivate && 'u' == cFinal)
+      bKittyReleases = nCode & 2;
+
+    // CSI < button ; x ; y M for a press, or m for a release
+    if ('<' == cPrivate && ('M' == cFinal || 'm' == cFinal))
+      MouseEvent(aMouse[0], aMouse[1] - 1, aMouse[2] - 1, 'm' == cFinal);
+
+    if ('\0' != cPrivate)
+      return;
+
+    // CSI I and CSI O, the terminal gained or lost focus
+    if (nBegin == nEnd && ('I' == cFinal || 'O' == cFinal)) {
+
+      cb::InputEvent event{};
+
+      event.nType = EVENT_FOCUS;
+
+      event.nAction = 'I' == cFinal;
+
+      event.tpTime = tpRead;
+
+      PushEvent(event);
+
+      return;
+    }
+
+    int nKey = 'u' == cFinal ? UnicodeKey(nCode) : FunctionKey(nCode, cFinal);
+
+    PushKey(nKey, bKittyReleases ? nEvent : 0);
+  }
+
+  void PushKey(int nKey, int nEvent) {
+
+    if (nKey < 0)
+      return;
+
+    cb::InputEvent event{};
+
+    event.nType = EVENT_KEY;
+
+    event.nAction = static_cast<short>(nEvent);
+
+    event.nKey = static_cast<uint16_t>(nKey);
+
+    event.tpTime = tpRead;
+
+    PushEvent(event);
+  }
+
+  // a motion is held back, to be replaced by a later one read at once
+  void PushEvent(const cb::InputEvent &event) {
+
+    FlushMotion();
+
+    qEvents.Push(event);
+  }
+
+  void FlushMotion() {
+
+    if (!bMotion)
+      return;
+
+    qEvents.Push(eMotion);
+
+    bMotion = false;
+  }
+
+  // a click is held back until no further press can make it a double or
+  // triple click, so that only the final count is reported, as with ncurses
+  void FlushClick() {
+
+    if (!bPendingClick)
+      return;
+
+    bPendingClick = false;
+
+    PushEvent(ePendingClick);
+  }
+
+  // nButton has the button in its lowest two bits, 3 being a release in the
+  // legacy encoding, then bits for shift, meta, control, motion and wheel;
+  // a press and release in quick succession add up to clicks as with ncurses
+  void MouseEvent(int nButton, int x, int y, bool bRelease) {
+
+    cb::InputEvent event{};
+
+    event.nType = EVENT_MOUSE;
+
+    event.x = x;
+
+    event.y = y;
+
+    event.tpTime = tpRead;
+
+    int b = nButton & 3;
+
+    // the count of the click the event completes, if any
+    int nClick = 0;
+
+    if (nButton & 64) {
+
+      if (0 == b)
+        event.nButtons = BUTTON4_PRESSED;
+#ifdef BUTTON5_PRESSED
+      else if (1 == b)
+        event.nButtons = BUTTON5_PRESSED;
+#endif
+    } else if (nButton & 32) {
+
+      event.nButtons = REPORT_MOUSE_POSITION;
+
+      if (3 != b)
+        event.nButtons |= NCURSES_MOUSE_MASK(b + 1, NCURSES_BUTTON_PRESSED);
+    } else if (bRelease || 3 == b) {
+
+      if (3 == b)
+        b = nLastButton;
+
+      event.nButtons = NCURSES_MOUSE_MASK(b + 1, NCURSES_BUTTON_RELEASED);
+
+      auto dInterval = std::chrono::milliseconds(nClickMilliseconds);
+
+      if (tpRead - tpPressed[b] <= dInterval) {
+
+        nClicks[b] = tpPressed[b] - tpClicked[b] <= dInterval
+                         ? std::min(nClicks[b] + 1, 3)
+                         : 1;
+
+        tpClicked[b] = tpRead;
+
+        nClick = nClicks[b];
+      }
+    } else {
+
+      event.nButtons = NCURSES_MOUSE_MASK(b + 1, NCURSES_BUTTON_PRESSED);
+
+      // a press in time may turn the click of the same button into the next
+      // count, so the click waits for its release
+      auto dInterval = std::chrono::milliseconds(nClickMilliseconds);
+
+      if (bPendingClick && b == nLastButton &&
+          tpRead - tpClicked[b] <= dInterval)
+        tpClickDeadline = tpRead + dInterval;
+      else
+        FlushClick();
+
+      tpPressed[b] = tpRead;
+
+      nLastButton = b;
+    }
+
+    if (nButton & 4)
+      event.nButtons |= BUTTON_SHIFT;
+
+    if (nButton & 8)
+      event.nButtons |= BUTTON_ALT;
+
+    if (nButton & 16)
+      event.nButtons |= BUTTON_CTRL;
+
+    if (nButton & 32) {
+      eMotion = event;
+      bMotion = true;
+    } else
+      PushEvent(event);
+
+    if (0 == nClick)
+      return;
+
+    // the next count replaces the click it adds to
+    if (nClick > 1)
+      bPendingClick = false;
+
+    FlushClick();
+
+    ePendingClick = event;
+
+    ePendingClick.nButtons =
+        NCURSES_MOUSE_MASK(b + 1, NCURSES_BUTTON_CLICKED << (nClick - 1)) |
+        (event.nButtons & (BUTTON_SHIFT | BUTTON_ALT | BUTTON_CTRL));
+
+    bPendingClick = true;
+
+    tpClickDeadline = tpRead + std::chrono::milliseconds(nClickMilliseconds);
+
+    // a triple click can not become more
+    if (3 == nClick)
+      FlushClick();
+  }
+
+  // nEvent is 1 for a press, 2 for a repeat, 3 for a release and 0 for a key
+  // that was struck without telling when it is released
+  void KeyEvent(int nKey, int nEvent) {
+
+    if (nKey < 0)
+      return;
+
+    UInt32 nBit = 1u << (nKey % 32);
+
+    if (3 == nEvent)
+      kmKeysHeld[nKey / 32].bigEndianValue &= ~nBit;
+    else {
+
+      if (0 != nEvent)
+        kmKeysHeld[nKey / 32].bigEndianValue |= nBit;
+
+      if (2 != nEvent)
+        kmKeysStruck[nKey / 32].bigEndianValue |= nBit;
+    }
+  }
+
+  // the key of a kitty key code, that is the unshifted character or a code
+  // in the private use area, or that of a legacy character
+  static int UnicodeKey(int nCode) {
+
+    static constexpr short nLetters[26] = {
+        kVK_ANSI_A, kVK_ANSI_B, kVK_ANSI_C, kVK_ANSI_D, kVK_ANSI_E,
+        kVK_ANSI_F, kVK_ANSI_G, kVK_ANSI_H, kVK_ANSI_I, kVK_ANSI_J,
+        kVK_ANSI_K, kVK_ANSI_L, kVK_ANSI_M, kVK_ANSI_N, kVK_ANSI_O,
+        kVK_ANSI_P, kVK_ANSI_Q, kVK_ANSI_R, kVK_ANSI_S, kVK_ANSI_T,
+        kVK_ANSI_U, kVK_ANSI_V, kVK_ANSI_W, kVK_ANSI_X, kVK_ANSI_Y,
+        kVK_ANSI_Z};
+
+    static constexpr short nDigits[10] = {
+        kVK_ANSI_0, kVK_ANSI_1, kVK_ANSI_2, kVK_ANSI_3, kVK_ANSI_4,
+        kVK_ANSI_5, kVK_ANSI_6, kVK_ANSI_7, kVK_ANSI_8, kVK_ANSI_9};
+
+    static constexpr short nKeypad[17] = {
+        kVK_ANSI_Keypad0,        kVK_ANSI_Keypad1,      kVK_ANSI_Keypad2,
+        kVK_ANSI_Keypad3,        kVK_ANSI_Keypad4,      kVK_ANSI_Keypad5,
+        kVK_ANSI_Keypad6,        kVK_ANSI_Keypad7,      kVK_ANSI_Keypad8,
+        kVK_ANSI_Keypad9,        kVK_ANSI_KeypadDecimal, kVK_ANSI_KeypadDivide,
+        kVK_ANSI_KeypadMultiply, kVK_ANSI_KeypadMinus,  kVK_ANSI_KeypadPlus,
+        kVK_ANSI_KeypadEnter,    kVK_ANSI_KeypadEquals};
+
+    static constexpr short nModifiers[10] = {
+        kVK_Shift,      kVK_Control,      kVK_Option,      kVK_Command, -1,
+        -1,             kVK_RightShift,   kVK_RightControl, kVK_RightOption,
+        kVK_RightCommand};
+
+    static constexpr short nFunctions[8] = {kVK_F13, kVK_F14, kVK_F15,
+                                            kVK_F16, kVK_F17, kVK_F18,
+                                            kVK_F19, kVK_F20};
+
+    if (nCode >= 'a' && nCode <= 'z')
+      return nLetters[nCode - 'a'];
+
+    if (nCode >= 'A' && nCode <= 'Z')
+      return nLetters[nCode - 'A'];
+
+    if (nCode >= '0' && nCode <= '9')
+      return nDigits[nCode - '0'];
+
+    if (nCode >= 57399 && nCode <= 57415)
+      return nKeypad[nCode - 57399];
+
+    if (nCode >= 57441 && nCode <= 57450)
+      return nModifiers[nCode - 57441];
+
+    if (nCode >= 57376 && nCode <= 57383)
+      return nFunctions[nCode - 57376];
+
+    switch (nCode) {
+    case '\t':
+      return kVK_Tab;
+    case '\r':
+    case '\n':
+      return kVK_Return;
+    case 8:
+    case 127:
+      return kVK_Delete;
+    case 27:
+      return kVK_Escape;
+    case ' ':
+      return kVK_Space;
+    case '-':
+      return kVK_ANSI_Minus;
+    case '=':
+      return kVK_ANSI_Equal;
+    case '[':
+      return kVK_ANSI_LeftBracket;
+    case ']':
+      return kVK_ANSI_RightBracket;
+    case '\\':
+      return kVK_ANSI_Backslash;
+    case ';':
+      return kVK_ANSI_Semicolon;
+    case '\'':
+      return kVK_ANSI_Quote;
+    case ',':
+      return kVK_ANSI_Comma;
+    case '.':
+      return kVK_ANSI_Period;
+    case '/':
+      return kVK_ANSI_Slash;
+    case '`':
+      return kVK_ANSI_Grave;
+    case 57358:
+      return kVK_CapsLock;
+    default:
+      return -1;
+    }
+  }
+
+  // the key of a CSI number ~ code, or of a CSI 1 letter or SS3 letter code
+  static int FunctionKey(int nCode, char cFinal) {
+
+    switch (cFinal) {
+    case 'A':
+      return kVK_UpArrow;
+    case 'B':
+      return kVK_DownArrow;
+    case 'C':
+      return kVK_RightArrow;
+    case 'D':
+      return kVK_LeftArrow;
+    case 'F':
+      return kVK_End;
+    case 'H':
+      return kVK_Home;
+    case 'P':
+      return kVK_F1;
+    case 'Q':
+      return kVK_F2;
+    case 'R':
+      return kVK_F3;
+    case 'S':
+      return kVK_F4;
+    case '~':
+      break;
+    default:
+      return -1;
+    }
+
+    switch (nCode) {
+    case 2:
+      return kVK_Help;
+    case 3:
+      return kVK_ForwardDelete;
+    case 1:
+    case 7:
+      return kVK_Home;
+    case 4:
+    case 8:
+      return kVK_End;
+    case 5:
+      return kVK_PageUp;
+    case 6:
+      return kVK_PageDown;
+    case 11:
+      return kVK_F1;
+    case 12:
+      return kVK_F2;
+    case 13:
+      return kVK_F3;
+    case 14:
+      return kVK_F4;
+    case 15:
+      return kVK_F5;
+    case 17:
+      return kVK_F6;
+    case 18:
+      return kVK_F7;
+    case 19:
+      return kVK_F8;
+    case 20:
+      return kVK_F9;
+    case 21:
+      return kVK_F10;
+    case 23:
+      return kVK_F11;
+    case 24:
+      return kVK_F12;
+    default:
+      return -1;
+    }
+  }
+
+  void WriteTerminal(const char *pSequence) {
+
+    size_t nLength = strlen(pSequence), nWritten = 0;
+
+    while (nWritten < nLength) {
+
+      ssize_t n = write(STDOUT_FILENO, pSequence + nWritten, nLength - nWritten);
+
+      if (n < 0 && EINTR == errno)
+        continue;
+
+      if (n <= 0)
+        return;
+
+      nWritten += n;
+    }
+  }
+
+  [[maybe_unused]] void GameThread() {
+
+    if (bRandomSeed)
+      srand(nRandomSeed);
+
+    if (OnUserCreate()) {
+
+      struct timespec sStartTimespec {
+      }, sStopTimespec{};
+
+      float fElapsedTime = 0.0f;
+
+      clock_gettime(CLOCK_MONOTONIC_RAW, &sStartTimespec);
+
+      auto tpNextFrame = std::chrono::steady_clock::now();
+
+      double fRecordingTime = 0.0;
+
+      if (!pRecordingFile.empty())
+        recorder.Open(
+            pRecordingFile,
+            (bTrueColor ? static_cast<uint32_t>(cb::RECORDING_FLAG_TRUECOLOR)
+                        : 0u) |
+                (2 == nPixelRows
+                     ? static_cast<uint32_t>(cb::RECORDING_FLAG_HALFBLOCK)
+                     : 0u));
+
+      while (m_bAtomActive) {
+
+        clock_gettime(CLOCK_MONOTONIC_RAW, &sStopTimespec);
+
+        auto tpUpdate = std::chrono::steady_clock::now();
+
+        ReadInput();
+
+        float fInputTime = std::chrono::duration<float, std::milli>(
+                               std::chrono::steady_clock::now() - tpUpdate)
+                               .count();
+
+        m_bAtomActive =
+            FixedUpdate(fElapsedTime) && OnUserUpdate(fElapsedTime);
+
+        if (OUTPUT_HEADLESS == nOutput)
+          fElapsedTime = fTargetFrameTime > 0.0f ? fTargetFrameTime
+                                                 : fHeadlessFrameTime;
+        else
+          fElapsedTime =
+              (float)(sStopTimespec.tv_sec - sStartTimespec.tv_sec) +
+              (float)(sStopTimespec.tv_nsec - sStartTimespec.tv_nsec) /
+                  1000000000.0f;
+
+        FlushDrawCommands();
+
+        ComposeLayers();
+
+        ComposeCanvases();
+
+        float fUpdateTime = std::chrono::duration<float, std::milli>(
+                                std::chrono::steady_clock::now() - tpUpdate)
+                                .count();
+
+        if (recorder.IsOpen())
+          recorder.Record(pScreenBuffer, pScreenColors, nScreenWidth,
+                          nScreenHeight, nRowStride, fRecordingTime);
+
+        fRecordingTime += fElapsedTime;
+
+        if (bPipelined)
+          SubmitFrame(fElapsedTime);
+        else {
+          Present(fElapsedTime);
+          SnapshotPresentMetrics();
+        }
+
+        RecordMetrics(fUpdateTime, fInputTime);
+
+        sStartTimespec = sStopTimespec;
+
+        if (++nFrameCount == nFrameLimit)
+          m_bAtomActive = false;
+
+        WaitForNextFrame(tpNextFrame);
+      }
+    }
+
+    StopOutput();
+
+    recorder.Close();
+
+    if (!pMetricsFile.empty())
+      DumpMetrics(pMetricsFile);
+  }
+
+  int nScreenWidth;
+
+  int nScreenHeight;
+
+  int nConsoleHeight;
+
+  int nPixelRows;
+
+  int nRowStride;
+
+  Display *XDisplay;
+
+  Window nWindowID;
+
+  int nColors;
+
+  cb::Cell *pScreenBuffer;
+
+  cb::Cell *pFrontBuffer;
+
+  cb::CellColors *pScreenColors;
+
+  cb::CellColors *pFrontColors;
+
+  static constexpr size_t nCellAlignment = 64;
+
+  static constexpr int nRowAlignment = nCellAlignment / sizeof(cb::Cell);
+
+  bool bTrueColor;
+
+  uint32_t nPalette[FG_COLORS]{};
+
+  cb::BrailleCanvas *pDrawTarget;
+
+  std::vector<cb::BrailleCanvas *> vCanvases;
+
+  bool bCanvasesComposed;
+
+  // where the drawing functions write to, and the dirty flag of the layer
+  // they set, if they draw to one
+  cb::Cell *pDrawBuffer;
+
+  cb::CellColors *pDrawColors;
+
+  bool *pDrawDirty;
+
+  typedef struct {
+    cb::Cell *pCells;
+    cb::CellColors *pColors;
+    bool bDirty;
+  } LayerBuffers;
+
+  LayerBuffers aLayers[LAYER_COUNT]{};
+
+  bool bLayered;
+
+  layers nLayer;
+
+  bool bBinned;
+
+  std::vector<DrawCommand> vDrawCommands;
+
+  // a tile spans whole cache lines of a row
+  static constexpr int nTileWidth = 32;
+
+  static constexpr int nTileHeight = 8;
+
+  int nTilesX;
+
+  int nTilesY;
+
+  std::vector<std::vector<uint32_t>> vBins;
+
+  std::atomic<int> nNextTile{};
+
+  cb::JobSystem jobs;
+
+  unsigned nWorkerThreads;
+
+  cb::Cell *pPendingBuffer;
+
+  cb::CellColors *pPendingColors;
+
+  const cb::Cell *pPresentBuffer{};
+
+  const cb::CellColors *pPresentColors{};
+
+  bool bPipelined;
+
+  // 0: output idle, 1: frame pending, 2: stop
+  std::atomic<int> nPipelineState{};
+
+  float fPendingElapsedTime;
+
+  std::mutex mOutput;
+
+  std::condition_variable cvOutput;
+
+  std::atomic<bool> bOutputParked{};
+
+  std::atomic<bool> bGameParked{};
+
+  static constexpr int nPipelineSpins = 256;
+
+  float fTargetFrameTime;
+
+  float fFixedTimestep;
+
+  float fFixedAccumulator;
+
+  static constexpr int nMaxFixedSteps = 8;
+
+  static constexpr int nPacingSpinMicroseconds = 1500;
+
+  static constexpr size_t nMetricsWindow = 256;
+
+  std::array<float, METRIC_COUNT> aMetrics[nMetricsWindow]{};
+
+  std::array<float, METRIC_COUNT> aPresentMetrics{};
+
+  size_t nMetricsFrames;
+
+  std::vector<std::array<float, METRIC_COUNT>> vMetricsLog;
+
+  std::filesystem::path pMetricsFile;
+
+  std::filesystem::path pRecordingFile;
+
+  cb::Recorder<cb::Cell, cb::CellColors> recorder;
+
+  size_t nPresentChangedCells;
+
+  size_t nPresentColorSwitches;
+
+  size_t nPresentBytesSaved;
+
+  float fPresentTime;
+
+  std::wstring wsRun;
+
+  outputs nOutput;
+
+  std::string sFrame;
+
+  size_t nFrameBytes;
+
+  size_t nFrameCount;
+
+  size_t nFrameLimit;
+
+  static constexpr float fHeadlessFrameTime = 1.0f / 60.0f;
+
+  typedef struct {
+    size_t nFrame;
+    uint16_t nKey;
+    bool bPressed;
+  } ScriptedKey;
+
+  std::vector<ScriptedKey> vScriptedKeys;
+
+  size_t nScriptedKey;
+
+  std::vector<std::pair<size_t, MEVENT>> vScriptedMice;
+
+  size_t nScriptedMouse;
+
+  unsigned nRandomSeed;
+
+  bool bRandomSeed;
+
+  std::vector<uint32_t> vGlyphs;
+
+  bool bRepeatGlyphs;
+
+  bool bEraseLines;
+
+  wchar_t nRepeatGlyph;
+
+  size_t nRepeatGlyphBytes;
+
+  size_t nRepeatCount;
+
+  int nCursorColumn;
+
+  static constexpr int nDiffBlockSize = 16;
+
+  static constexpr int nDiffRunGap = 8;
+
+  KeyMap kmKeys{};
+
+  KeyMap kmKeysPrevious{};
+
+  // the keys held down and those pressed since the last frame, as reported
+  // by the terminal with bKittyKeys
+  KeyMap kmKeysHeld{};
+
+  KeyMap kmKeysStruck{};
+
+  bool bKittyKeys;
+
+  // the terminal replied that it reports releases
+  bool bKittyReleases;
+
+  // read by InputThread and not yet parsed
+  std::string sInput;
+
+  std::chrono::steady_clock::time_point tpRead;
+
+  cb::RingBuffer<cb::InputEvent, 1024> qEvents;
+
+  // the events of this frame, and how many PollEvent() returned
+  std::vector<cb::InputEvent> vEvents;
+
+  size_t nEventsPolled;
+
+  // per mouse button, for telling clicks apart
+  std::chrono::steady_clock::time_point tpPressed[3];
+
+  std::chrono::steady_clock::time_point tpClicked[3];
+
+  int nClicks[3];
+
+  int nLastButton;
+
+  // the click waiting for the interval to pass without a further press
+  cb::InputEvent ePendingClick{};
+
+  bool bPendingClick;
+
+  std::chrono::steady_clock::time_point tpClickDeadline;
+
+  // the motion read last and not yet queued
+  cb::InputEvent eMotion{};
+
+  bool bMotion;
+
+  // the mouseinterval() of ncurses
+  static constexpr int nClickMilliseconds = 166;
+
+  static constexpr char cWakeResize = 'r';
+
+  static constexpr char cWakeStop = 'q';
+
+  // written to wake InputThread, also from the SIGWINCH handler
+  inline static int nWakePipe[2] = {-1, -1};
+
+  // written to wake FocusThread to stop
+  int nFocusPipe[2] = {-1, -1};
+
+
+  std::thread loop;
+
+  std::thread focus;
+
+  std::thread output;
+
+  std::thread input;
 
   std::atomic<bool> m_bAtomActive{};
 
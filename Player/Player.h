@@ -0,0 +1,102 @@
+/**
+ *  @file   Player.h
+ *  @brief  Replays recordings of the NCursesGameEngine
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_PLAYER_H
+#define CBNCURSESGAMEENGINE_PLAYER_H
+
+#include "../NCursesGameEngine.h"
+
+#include <filesystem>
+
+class Player : public cb::NCursesGameEngine {
+
+  cb::Replay<cb::Cell, cb::CellColors> replay;
+
+  bool bMaxSpeed;
+
+  // a frame is read ahead and shown once the clock reaches its time
+  bool bFrame = false;
+
+  double fClock = 0.0;
+
+public:
+  Player(const std::filesystem::path &filename, bool bMaxSpeed)
+      : bMaxSpeed(bMaxSpeed) {
+
+    if (replay.Open(filename))
+      bFrame = replay.Next();
+  }
+
+  [[maybe_unused]] inline bool IsOpen() const { return bFrame; }
+
+  // plays the recording in the modes it was made in
+  [[maybe_unused]] inline int Modes() const {
+    return (replay.IsTrueColor() ? MODE_TRUECOLOR : 0) |
+           (replay.IsHalfBlock() ? MODE_HALFBLOCK : 0);
+  }
+
+  bool OnUserCreate() override {
+
+    SetTargetFPS(bMaxSpeed ? 0.0f : 120.0f);
+
+    return true;
+  }
+
+  bool OnUserUpdate(float fElapsedTime) override {
+
+    if (KeyDown(kVK_ANSI_Q))
+      return false;
+
+    fClock += fElapsedTime;
+
+    // the last frame stays on screen
+    if (bMaxSpeed) {
+
+      if (bFrame) {
+
+        Show();
+
+        bFrame = replay.Next();
+      }
+    } else
+      while (bFrame && replay.Time() <= fClock) {
+
+        Show();
+
+        bFrame = replay.Next();
+      }
+
+    return true;
+  }
+
+private:
+  void Show() {
+
+    if (replay.IsTrueColor())
+      Clear(L' ', 0x000000, 0x000000);
+    else
+      Clear(L' ', FG_BLACK);
+
+    for (int y = 0; y < replay.Height(); y++)
+      for (int x = 0; x < replay.Width(); x++) {
+
+        const cb::Cell &cell = replay.At(x, y);
+
+        if (replay.IsTrueColor()) {
+
+          const cb::CellColors &colors = replay.ColorsAt(x, y);
+
+          DrawPixel(x, y, cell.character, colors.foreground, colors.background);
+        } else
+          DrawPixel(x, y, cell.character, cell.color);
+      }
+  }
+};
+
+#endif // CBNCURSESGAMEENGINE_PLAYER_H
@@ -0,0 +1,33 @@
+/**
+ *  @file   main.cpp
+ *  @brief  Player
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "Player.h"
+
+#include <cstring>
+#include <iostream>
+
+int main(const int argc, const char *argv[]) {
+
+    if (argc < 2 || (argc > 2 && 0 != strcmp(argv[2], "--max"))) {
+        std::cerr << "usage: " << argv[0] << " recording [--max]" << std::endl;
+        return 1;
+    }
+
+    Player p(argv[1], argc > 2);
+
+    if (!p.IsOpen()) {
+        std::cerr << argv[1] << ": not a recording" << std::endl;
+        return 1;
+    }
+
+    p.ConstructConsole(cb::NCursesGameEngine::OUTPUT_NCURSES, p.Modes());
+    p.Start();
+
+    return 0;
+}
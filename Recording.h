@@ -0,0 +1,571 @@
+/**
+ *  @file   Recording.h
+ *  @brief  Recording and replay of sessions of the NCursesGameEngine
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_RECORDING_H
+#define CBNCURSESGAMEENGINE_RECORDING_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <zlib.h>
+}
+
+// A recording starts with a header of the magic "NCGR", the version and the
+// flags, all uint32_t. Every frame follows as the uint32_t sizes of its zlib
+// compressed and its raw data, and the compressed data. The raw data is the
+// time in seconds as a double, the int32_t width and height, a byte that is
+// 1 for a keyframe and then for a keyframe all cells, or otherwise the
+// uint32_t number of runs of changed cells followed by each run as its
+// uint32_t start and length and its cells. With FLAG_TRUECOLOR the colors of
+// each cell follow the cells. Cells are stored as they are in memory.
+
+namespace cb {
+template <typename Cell, typename Colors> class Recorder;
+template <typename Cell, typename Colors> class Replay;
+enum [[maybe_unused]] recordings : uint32_t{
+    RECORDING_MAGIC = 0x5247434e, RECORDING_VERSION = 1,
+    RECORDING_FLAG_TRUECOLOR = 1 << 0, RECORDING_FLAG_HALFBLOCK = 1 << 1};
+}; // namespace cb
+
+// Writes frames on a thread of its own. Record() copies a frame into one of
+// a few slots and returns right away; when all are taken the frame is
+// dropped, rather than the game waiting for the disk. The thread encodes each
+// frame against the one it encoded before, so a dropped frame only makes the
+// next delta larger. The first write that fails stops the recording.
+template <typename Cell, typename Colors> class cb::Recorder {
+
+public:
+  Recorder() = default;
+
+  ~Recorder() { Close(); }
+
+  Recorder(const Recorder &) = delete;
+
+  Recorder &operator=(const Recorder &) = delete;
+
+  [[maybe_unused]] bool Open(const std::filesystem::path &filename,
+                             uint32_t nFlags) {
+
+    Close();
+
+    pFile = fopen(filename.c_str(), "wb");
+
+    if (nullptr == pFile)
+      return false;
+
+    uint32_t nHeader[3] = {RECORDING_MAGIC, RECORDING_VERSION, nFlags};
+
+    if (1 != fwrite(nHeader, sizeof(nHeader), 1, pFile)) {
+
+      fclose(pFile);
+
+      pFile = nullptr;
+
+      return false;
+    }
+
+    bFailed = false;
+
+    bColors = nFlags & RECORDING_FLAG_TRUECOLOR;
+
+    bStop = false;
+
+    nDropped = 0;
+
+    nFramesSinceKeyframe = nKeyframeInterval;
+
+    vPrevious.clear();
+
+    for (auto &slot : aSlots)
+      dFree.push_back(&slot);
+
+    writer = std::thread(&Recorder::WriterThread, this);
+
+    return true;
+  }
+
+  // writes the frames still queued
+  [[maybe_unused]] void Close() {
+
+    if (nullptr == pFile)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(mSlots);
+      bStop = true;
+    }
+
+    cvSlots.notify_all();
+
+    writer.join();
+
+    if (0 != fclose(pFile))
+      bFailed = true;
+
+    pFile = nullptr;
+
+    dFree.clear();
+
+    dQueued.clear();
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline bool IsOpen() const {
+    return nullptr != pFile;
+  }
+
+  // a write failed, for instance as the disk is full; the frames from then
+  // on are not recorded
+  [[maybe_unused]] [[nodiscard]] inline bool Failed() const { return bFailed; }
+
+  // pColors is only read with RECORDING_FLAG_TRUECOLOR; rows are nRowStride
+  // cells apart
+  [[maybe_unused]] bool Record(const Cell *pCells, const Colors *pColors,
+                               int nWidth, int nHeight, int nRowStride,
+                               double fTime) {
+
+    if (bFailed)
+      return false;
+
+    Slot *pSlot;
+
+    {
+      std::lock_guard<std::mutex> lock(mSlots);
+
+      if (dFree.empty()) {
+        nDropped++;
+        return false;
+      }
+
+      pSlot = dFree.front();
+
+      dFree.pop_front();
+    }
+
+    pSlot->fTime = fTime;
+
+    pSlot->nWidth = nWidth;
+
+    pSlot->nHeight = nHeight;
+
+    pSlot->vCells.resize(static_cast<size_t>(nWidth) * nHeight);
+
+    for (int y = 0; y < nHeight; y++)
+      std::copy_n(pCells + y * nRowStride, nWidth,
+                  pSlot->vCells.begin() + y * nWidth);
+
+    if (bColors) {
+
+      pSlot->vColors.resize(pSlot->vCells.size());
+
+      for (int y = 0; y < nHeight; y++)
+        std::copy_n(pColors + y * nRowStride, nWidth,
+                    pSlot->vColors.begin() + y * nWidth);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mSlots);
+      dQueued.push_back(pSlot);
+    }
+
+    cvSlots.notify_one();
+
+    return true;
+  }
+
+  // the frames that found no free slot
+  [[maybe_unused]] [[nodiscard]] inline size_t Dropped() const {
+    return nDropped;
+  }
+
+private:
+  typedef struct {
+    double fTime;
+    int nWidth;
+    int nHeight;
+    std::vector<Cell> vCells;
+    std::vector<Colors> vColors;
+  } Slot;
+
+  void WriterThread() {
+
+    while (true) {
+
+      Slot *pSlot;
+
+      {
+        std::unique_lock<std::mutex> lock(mSlots);
+
+        cvSlots.wait(lock, [this] { return bStop || !dQueued.empty(); });
+
+        if (dQueued.empty())
+          break;
+
+        pSlot = dQueued.front();
+
+        dQueued.pop_front();
+      }
+
+      if (!bFailed && !Write(*pSlot))
+        bFailed = true;
+
+      {
+        std::lock_guard<std::mutex> lock(mSlots);
+        dFree.push_back(pSlot);
+      }
+    }
+
+    if (!bFailed && 0 != fflush(pFile))
+      bFailed = true;
+  }
+
+  bool Write(Slot &slot) {
+
+    vRaw.clear();
+
+    Append(&slot.fTime, sizeof(slot.fTime));
+
+    int32_t nSize[2] = {slot.nWidth, slot.nHeight};
+
+    Append(nSize, sizeof(nSize));
+
+    bool bKeyframe = nFramesSinceKeyframe >= nKeyframeInterval ||
+                     slot.nWidth != nPreviousWidth ||
+                     slot.nHeight != nPreviousHeight;
+
+    uint8_t nKeyframe = bKeyframe;
+
+    Append(&nKeyframe, sizeof(nKeyframe));
+
+    if (bKeyframe) {
+
+      AppendCells(slot, 0, slot.vCells.size());
+
+      nFramesSinceKeyframe = 0;
+    } else
+      AppendRuns(slot);
+
+    nFramesSinceKeyframe++;
+
+    uLongf nCompressed = compressBound(vRaw.size());
+
+    vCompressed.resize(nCompressed);
+
+    if (Z_OK != compress2(vCompressed.data(), &nCompressed, vRaw.data(),
+                          vRaw.size(), Z_BEST_SPEED))
+      return false;
+
+    uint32_t nSizes[2] = {static_cast<uint32_t>(nCompressed),
+                          static_cast<uint32_t>(vRaw.size())};
+
+    if (1 != fwrite(nSizes, sizeof(nSizes), 1, pFile) ||
+        nCompressed != fwrite(vCompressed.data(), 1, nCompressed, pFile))
+      return false;
+
+    nPreviousWidth = slot.nWidth;
+
+    nPreviousHeight = slot.nHeight;
+
+    vPrevious.swap(slot.vCells);
+
+    vPreviousColors.swap(slot.vColors);
+
+    return true;
+  }
+
+  // the runs of cells that differ from the previous frame; runs that are
+  // less than nRunGap cells apart are joined, as a run costs 8 bytes
+  void AppendRuns(const Slot &slot) {
+
+    size_t nCountAt = vRaw.size();
+
+    uint32_t nRuns = 0;
+
+    Append(&nRuns, sizeof(nRuns));
+
+    size_t nCells = slot.vCells.size(), i = 0;
+
+    while (i < nCells) {
+
+      if (!Changed(slot, i)) {
+        i++;
+        continue;
+      }
+
+      size_t nStart = i, nEnd = i + 1, nSame = 0;
+
+      for (i++; i < nCells && nSame < nRunGap; i++)
+        if (Changed(slot, i)) {
+          nEnd = i + 1;
+          nSame = 0;
+        } else
+          nSame++;
+
+      uint32_t nRun[2] = {static_cast<uint32_t>(nStart),
+                          static_cast<uint32_t>(nEnd - nStart)};
+
+      Append(nRun, sizeof(nRun));
+
+      AppendCells(slot, nStart, nEnd - nStart);
+
+      nRuns++;
+
+      i = nEnd;
+    }
+
+    memcpy(vRaw.data() + nCountAt, &nRuns, sizeof(nRuns));
+  }
+
+  inline bool Changed(const Slot &slot, size_t i) const {
+
+    if (0 != memcmp(&slot.vCells[i], &vPrevious[i], sizeof(Cell)))
+      return true;
+
+    return bColors &&
+           0 != memcmp(&slot.vColors[i], &vPreviousColors[i], sizeof(Colors));
+  }
+
+  void AppendCells(const Slot &slot, size_t nStart, size_t nCount) {
+
+    Append(slot.vCells.data() + nStart, nCount * sizeof(Cell));
+
+    if (bColors)
+      Append(slot.vColors.data() + nStart, nCount * sizeof(Colors));
+  }
+
+  inline void Append(const void *pData, size_t nBytes) {
+
+    const auto *pBytes = static_cast<const Bytef *>(pData);
+
+    vRaw.insert(vRaw.end(), pBytes, pBytes + nBytes);
+  }
+
+  static constexpr int nSlots = 8;
+
+  static constexpr int nKeyframeInterval = 120;
+
+  static constexpr size_t nRunGap = 2;
+
+  FILE *pFile = nullptr;
+
+  bool bColors = false;
+
+  Slot aSlots[nSlots]{};
+
+  // the slots free to record into and those waiting to be written
+  std::deque<Slot *> dFree;
+
+  std::deque<Slot *> dQueued;
+
+  std::mutex mSlots;
+
+  std::condition_variable cvSlots;
+
+  bool bStop = false;
+
+  size_t nDropped = 0;
+
+  // set by the writer thread, read by the game
+  std::atomic<bool> bFailed{false};
+
+  std::thread writer;
+
+  // only used by the writer thread
+  std::vector<Bytef> vRaw;
+
+  std::vector<Bytef> vCompressed;
+
+  std::vector<Cell> vPrevious;
+
+  std::vector<Colors> vPreviousColors;
+
+  int nPreviousWidth = 0;
+
+  int nPreviousHeight = 0;
+
+  int nFramesSinceKeyframe = 0;
+};
+
+// Reads a recording back one frame at a time.
+template <typename Cell, typename Colors> class cb::Replay {
+
+public:
+  Replay() = default;
+
+  ~Replay() {
+
+    if (nullptr != pFile)
+      fclose(pFile);
+  }
+
+  Replay(const Replay &) = delete;
+
+  Replay &operator=(const Replay &) = delete;
+
+  [[maybe_unused]] bool Open(const std::filesystem::path &filename) {
+
+    pFile = fopen(filename.c_str(), "rb");
+
+    if (nullptr == pFile)
+      return false;
+
+    uint32_t nHeader[3];
+
+    if (1 != fread(nHeader, sizeof(nHeader), 1, pFile) ||
+        RECORDING_MAGIC != nHeader[0] || RECORDING_VERSION != nHeader[1])
+      return false;
+
+    nFlags = nHeader[2];
+
+    return true;
+  }
+
+  // false at the end of the recording or when it is damaged
+  [[maybe_unused]] bool Next() {
+
+    uint32_t nSizes[2];
+
+    if (nullptr == pFile || 1 != fread(nSizes, sizeof(nSizes), 1, pFile))
+      return false;
+
+    vCompressed.resize(nSizes[0]);
+
+    vRaw.resize(nSizes[1]);
+
+    uLongf nRaw = nSizes[1];
+
+    if (nSizes[0] != fread(vCompressed.data(), 1, nSizes[0], pFile) ||
+        Z_OK != uncompress(vRaw.data(), &nRaw, vCompressed.data(), nSizes[0]) ||
+        nRaw != nSizes[1])
+      return false;
+
+    nOffset = 0;
+
+    int32_t nSize[2];
+
+    uint8_t nKeyframe;
+
+    if (!Take(&fTime, sizeof(fTime)) || !Take(nSize, sizeof(nSize)) ||
+        !Take(&nKeyframe, sizeof(nKeyframe)) || nSize[0] < 0 || nSize[1] < 0)
+      return false;
+
+    size_t nCells = static_cast<size_t>(nSize[0]) * nSize[1];
+
+    if (nKeyframe) {
+
+      nWidth = nSize[0];
+
+      nHeight = nSize[1];
+
+      vCells.resize(nCells);
+
+      vColors.resize(IsTrueColor() ? nCells : 0);
+
+      return TakeCells(0, nCells);
+    }
+
+    // a delta needs the keyframe it follows
+    if (nSize[0] != nWidth || nSize[1] != nHeight)
+      return false;
+
+    uint32_t nRuns;
+
+    if (!Take(&nRuns, sizeof(nRuns)))
+      return false;
+
+    for (uint32_t n = 0; n < nRuns; n++) {
+
+      uint32_t nRun[2];
+
+      if (!Take(nRun, sizeof(nRun)) ||
+          static_cast<size_t>(nRun[0]) + nRun[1] > nCells ||
+          !TakeCells(nRun[0], nRun[1]))
+        return false;
+    }
+
+    return true;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline bool IsTrueColor() const {
+    return nFlags & RECORDING_FLAG_TRUECOLOR;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline bool IsHalfBlock() const {
+    return nFlags & RECORDING_FLAG_HALFBLOCK;
+  }
+
+  // of the last frame read
+  [[maybe_unused]] [[nodiscard]] inline double Time() const { return fTime; }
+
+  [[maybe_unused]] [[nodiscard]] inline int Width() const { return nWidth; }
+
+  [[maybe_unused]] [[nodiscard]] inline int Height() const { return nHeight; }
+
+  [[maybe_unused]] [[nodiscard]] inline const Cell &At(int x, int y) const {
+    return vCells[x + y * nWidth];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const Colors &ColorsAt(int x,
+                                                               int y) const {
+    return vColors[x + y * nWidth];
+  }
+
+private:
+  bool Take(void *pData, size_t nBytes) {
+
+    if (nOffset + nBytes > vRaw.size())
+      return false;
+
+    memcpy(pData, vRaw.data() + nOffset, nBytes);
+
+    nOffset += nBytes;
+
+    return true;
+  }
+
+  bool TakeCells(size_t nStart, size_t nCount) {
+
+    if (!Take(vCells.data() + nStart, nCount * sizeof(Cell)))
+      return false;
+
+    return !IsTrueColor() ||
+           Take(vColors.data() + nStart, nCount * sizeof(Colors));
+  }
+
+  FILE *pFile = nullptr;
+
+  uint32_t nFlags = 0;
+
+  std::vector<Bytef> vCompressed;
+
+  std::vector<Bytef> vRaw;
+
+  size_t nOffset = 0;
+
+  double fTime = 0.0;
+
+  int nWidth = 0;
+
+  int nHeight = 0;
+
+  std::vector<Cell> vCells;
+
+  std::vector<Colors> vColors;
+};
+
+#endif // CBNCURSESGAMEENGINE_RECORDING_H
@@ -0,0 +1,79 @@
+/**
+ *  @file   RingBuffer.h
+ *  @brief  Lock-free single producer, single consumer queue
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef CBNCURSESGAMEENGINE_RINGBUFFER_H
+#define CBNCURSESGAMEENGINE_RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace cb {
+template <typename T, size_t nCapacity> class RingBuffer;
+}; // namespace cb
+
+// A fixed size queue for exactly one thread pushing and one thread popping.
+// Each side only writes its own index, and publishes an element by storing
+// that index with release semantics, so no locks are needed. The indices
+// count up freely and are wrapped on access, hence the power of two.
+template <typename T, size_t nCapacity> class cb::RingBuffer {
+
+  static_assert(0 == (nCapacity & (nCapacity - 1)),
+                "the capacity is expected to be a power of two");
+
+public:
+  RingBuffer() = default;
+
+  RingBuffer(const RingBuffer &) = delete;
+
+  RingBuffer &operator=(const RingBuffer &) = delete;
+
+  // false, dropping the element, when the queue is full
+  [[maybe_unused]] bool Push(const T &element) {
+
+    size_t nTail = nWrite.load(std::memory_order_relaxed);
+
+    if (nTail - nRead.load(std::memory_order_acquire) == nCapacity)
+      return false;
+
+    aElements[nTail & (nCapacity - 1)] = element;
+
+    nWrite.store(nTail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  [[maybe_unused]] bool Pop(T &element) {
+
+    size_t nHead = nRead.load(std::memory_order_relaxed);
+
+    if (nHead == nWrite.load(std::memory_order_acquire))
+      return false;
+
+    element = aElements[nHead & (nCapacity - 1)];
+
+    nRead.store(nHead + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline bool Empty() const {
+    return nRead.load(std::memory_order_acquire) ==
+           nWrite.load(std::memory_order_acquire);
+  }
+
+private:
+  T aElements[nCapacity]{};
+
+  // on separate cache lines, as each is written by another thread
+  alignas(64) std::atomic<size_t> nWrite{0};
+
+  alignas(64) std::atomic<size_t> nRead{0};
+};
+
+#endif // CBNCURSESGAMEENGINE_RINGBUFFER_H
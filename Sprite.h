@@ -15,6 +15,7 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 extern "C" {
 #include <zlib.h>
@@ -22,20 +23,31 @@ extern "C" {
 
 namespace cb {
 class Sprite;
+// laid out as a cb::Cell of the engine, with reserved kept zero, so rows of
+// pixels copy straight to the screen
 typedef struct {
   wchar_t character;
   short color;
+  short reserved;
 } Pixel;
 }; // namespace cb
 
 class cb::Sprite {
 
 public:
+  // the character of pixels that are not drawn, PIXEL_TRANSPARENT of the
+  // engine
+  static constexpr wchar_t cTransparent = -1;
+
   Sprite() {
 
     nSpriteWidth = 0;
     nSpriteHeight = 0;
     pPixels = nullptr;
+    bRunsStale = true;
+    bOpaque = true;
+    bMipmapped = false;
+    bMipsStale = true;
   }
 
   [[maybe_unused]] bool Create(int nWidth, int nHeight) {
@@ -48,7 +60,9 @@ public:
 
     delete pPixels;
     pPixels = new cb::Pixel[nSpriteWidth * nSpriteHeight];
-    std::fill_n(pPixels, nSpriteWidth * nSpriteHeight, (cb::Pixel){L' ', 0});
+    std::fill_n(pPixels, nSpriteWidth * nSpriteHeight, (cb::Pixel){L' ', 0, 0});
+
+    Changed();
 
     return true;
   }
@@ -63,9 +77,14 @@ public:
     return false;
   }
 
+  // reads the sprite from where the stream is, as part of a larger file
+  [[maybe_unused]] bool Read(std::istream &in) {
+    return ReadFromStream(in) && !in.fail();
+  }
+
   [[maybe_unused]] bool Load(const char *d, std::streamsize s) {
 
-    std::istringstream istrstr(d, s);
+    std::istringstream istrstr(std::string(d, s));
 
     return ReadFromStream(istrstr);
   }
@@ -77,7 +96,7 @@ public:
     uncompress(reinterpret_cast<Bytef *>(d), &s,
                reinterpret_cast<const Bytef *>(z), s_z);
 
-    std::istringstream istrstr(d, s);
+    std::istringstream istrstr(std::string(d, s));
 
     bool ok = ReadFromStream(istrstr);
 
@@ -123,8 +142,12 @@ public:
         pPixels[i].color = colors[i];
         pPixels[i].character = glyphs[i]; // == ' ' ? ' ' : L'\u2588';
       }
+
+      pPixels[i].reserved = 0;
     }
 
+    Changed();
+
     delete[] colors;
     delete[] glyphs;
 
@@ -141,17 +164,183 @@ public:
     if (ofstr.fail())
       return false;
 
-    ofstr.write(reinterpret_cast<char *>(&nSpriteWidth), sizeof(int));
-    ofstr.write(reinterpret_cast<char *>(&nSpriteHeight), sizeof(int));
-    ofstr.write(reinterpret_cast<char *>(pPixels),
-                nSpriteWidth * nSpriteHeight * sizeof(cb::Pixel));
+    return Write(ofstr);
+  }
 
-    return true;
+  [[maybe_unused]] bool Write(std::ostream &out) {
+
+    if (nSpriteWidth * nSpriteHeight <= 0)
+      return false;
+
+    out.write(reinterpret_cast<char *>(&nSpriteWidth), sizeof(int));
+    out.write(reinterpret_cast<char *>(&nSpriteHeight), sizeof(int));
+    out.write(reinterpret_cast<char *>(pPixels),
+              nSpriteWidth * nSpriteHeight * sizeof(cb::Pixel));
+
+    return !out.fail();
   }
 
   ~Sprite() { delete pPixels; }
 
-  [[maybe_unused]] cb::Pixel &operator[](unsigned i) { return pPixels[i]; }
+  // the pixel may be changed through the reference, so the runs are redone
+  [[maybe_unused]] cb::Pixel &operator[](unsigned i) {
+    Changed();
+    return pPixels[i];
+  }
+
+  // reading a pixel keeps the runs and mip levels
+  [[maybe_unused]] const cb::Pixel &operator[](unsigned i) const {
+    return pPixels[i];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const cb::Pixel &
+  GetPixel(unsigned i) const {
+    return pPixels[i];
+  }
+
+  [[maybe_unused]] inline void SetPixel(unsigned i, const cb::Pixel &pixel) {
+    pPixels[i] = pixel;
+    Changed();
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const cb::Pixel *Pixels() const {
+    return pPixels;
+  }
+
+  // a run of pixels of a row that are drawn, from nBegin up to nEnd
+  typedef struct {
+    int nBegin;
+    int nEnd;
+  } Run;
+
+  // finds the runs of every row between the pixels with the character
+  // PIXEL_TRANSPARENT of the engine, which are not drawn, when pixels may
+  // have changed since; the engine does so before drawing the sprite
+  [[maybe_unused]] void IndexRuns() {
+
+    if (!bRunsStale)
+      return;
+
+    vRuns.clear();
+
+    vRowRuns.assign(nSpriteHeight + 1, 0);
+
+    for (int y = 0; y < nSpriteHeight; y++) {
+
+      vRowRuns[y] = static_cast<int>(vRuns.size());
+
+      const cb::Pixel *pRow = pPixels + y * nSpriteWidth;
+
+      for (int x = 0; x < nSpriteWidth;) {
+
+        while (x < nSpriteWidth && cTransparent == pRow[x].character)
+          x++;
+
+        int nBegin = x;
+
+        while (x < nSpriteWidth && cTransparent != pRow[x].character)
+          x++;
+
+        if (x > nBegin)
+          vRuns.push_back({nBegin, x});
+      }
+    }
+
+    vRowRuns[nSpriteHeight] = static_cast<int>(vRuns.size());
+
+    bOpaque = true;
+
+    for (int y = 0; y < nSpriteHeight && bOpaque; y++)
+      bOpaque = 1 == vRowRuns[y + 1] - vRowRuns[y] &&
+                nSpriteWidth == vRuns[vRowRuns[y]].nEnd - vRuns[vRowRuns[y]].nBegin;
+
+    bRunsStale = false;
+  }
+
+  // without transparent pixels rows are drawn whole
+  [[maybe_unused]] [[nodiscard]] inline bool IsOpaque() const {
+    return bOpaque;
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const Run *RowRunsBegin(int y) const {
+    return vRuns.data() + vRowRuns[y];
+  }
+
+  [[maybe_unused]] [[nodiscard]] inline const Run *RowRunsEnd(int y) const {
+    return vRuns.data() + vRowRuns[y + 1];
+  }
+
+  // keeps levels of half the size of the one before, down to a single pixel,
+  // which draws scaled down sample instead of the sprite itself
+  [[maybe_unused]] void GenerateMips() {
+
+    bMipmapped = true;
+
+    bMipsStale = true;
+
+    UpdateMips();
+  }
+
+  // builds the levels again when pixels may have changed since; the engine
+  // does so before drawing the sprite scaled
+  [[maybe_unused]] void UpdateMips() {
+
+    if (!bMipmapped || !bMipsStale)
+      return;
+
+    vMips.clear();
+
+    int nWidth = nSpriteWidth, nHeight = nSpriteHeight;
+
+    while (nWidth > 1 || nHeight > 1) {
+
+      const cb::Pixel *pSource =
+          vMips.empty() ? pPixels : vMips.back().vPixels.data();
+
+      Mip mip{(nWidth + 1) / 2, (nHeight + 1) / 2, {}};
+
+      mip.vPixels.resize(mip.nWidth * mip.nHeight);
+
+      for (int y = 0; y < mip.nHeight; y++)
+        for (int x = 0; x < mip.nWidth; x++)
+          mip.vPixels[x + y * mip.nWidth] =
+              Downsample(pSource, nWidth, nHeight, 2 * x, 2 * y);
+
+      nWidth = mip.nWidth;
+
+      nHeight = mip.nHeight;
+
+      vMips.emplace_back(std::move(mip));
+    }
+
+    bMipsStale = false;
+  }
+
+  // the sprite itself is level 0
+  [[maybe_unused]] [[nodiscard]] inline int Levels() const {
+    return 1 + static_cast<int>(vMips.size());
+  }
+
+  [[maybe_unused]] inline const cb::Pixel *LevelPixels(int nLevel, int &nWidth,
+                                                       int &nHeight) const {
+
+    if (0 == nLevel) {
+
+      nWidth = nSpriteWidth;
+
+      nHeight = nSpriteHeight;
+
+      return pPixels;
+    }
+
+    const Mip &mip = vMips[nLevel - 1];
+
+    nWidth = mip.nWidth;
+
+    nHeight = mip.nHeight;
+
+    return mip.vPixels.data();
+  }
 
   [[maybe_unused]] [[nodiscard]] inline int SpriteWidth() const {
     return nSpriteWidth;
@@ -162,9 +351,69 @@ public:
   }
 
 private:
+  typedef struct {
+    int nWidth;
+    int nHeight;
+    std::vector<cb::Pixel> vPixels;
+  } Mip;
+
   int nSpriteWidth;
   int nSpriteHeight;
   cb::Pixel *pPixels;
+  bool bRunsStale;
+  bool bOpaque;
+  std::vector<Run> vRuns;
+  std::vector<int> vRowRuns;
+  bool bMipmapped;
+  bool bMipsStale;
+  std::vector<Mip> vMips;
+
+  inline void Changed() {
+    bRunsStale = true;
+    bMipsStale = true;
+  }
+
+  // the pixel seen most in the block of 2x2 pixels at (x, y), as glyphs can
+  // not be averaged, or a transparent one when most of the block is
+  static cb::Pixel Downsample(const cb::Pixel *pSource, int nWidth, int nHeight,
+                              int x, int y) {
+
+    const cb::Pixel *aBlock[4];
+
+    int nCount = 0, nOpaque = 0;
+
+    for (int dy = 0; dy < 2 && y + dy < nHeight; dy++)
+      for (int dx = 0; dx < 2 && x + dx < nWidth; dx++) {
+
+        const cb::Pixel *pPixel = pSource + (x + dx) + (y + dy) * nWidth;
+
+        nCount++;
+
+        if (cTransparent != pPixel->character)
+          aBlock[nOpaque++] = pPixel;
+      }
+
+    if (2 * nOpaque < nCount)
+      return {cTransparent, 0, 0};
+
+    int nBest = 0, nBestVotes = 0;
+
+    for (int i = 0; i < nOpaque; i++) {
+
+      int nVotes = 0;
+
+      for (int j = 0; j < nOpaque; j++)
+        nVotes += aBlock[i]->character == aBlock[j]->character &&
+                  aBlock[i]->color == aBlock[j]->color;
+
+      if (nVotes > nBestVotes) {
+        nBest = i;
+        nBestVotes = nVotes;
+      }
+    }
+
+    return *aBlock[nBest];
+  }
 
   bool ReadFromStream(std::istream &in) {
 
@@ -179,6 +428,12 @@ private:
     in.read(reinterpret_cast<char *>(pPixels),
             nSpriteWidth * nSpriteHeight * sizeof(cb::Pixel));
 
+    // written by older versions as padding
+    for (int i = 0; i < nSpriteWidth * nSpriteHeight; i++)
+      pPixels[i].reserved = 0;
+
+    Changed();
+
     return true;
   }
 };
@@ -18,6 +18,8 @@ public:
 
     bShowFPS = false;
 
+    SetTargetFPS(43.0f);
+
     if (argc > 1) {
       Sprite.ReadolcSprite(std::wstring(argv[1], argv[1] + strlen(argv[1])));
       nSpriteSize = std::max(Sprite.SpriteHeight(), Sprite.SpriteWidth());
@@ -30,7 +32,7 @@ public:
 private:
   bool OnUserCreate() final {
 
-    pixel = {PIXEL_FULL, FG_BLACK};
+    pixel = {PIXEL_FULL, FG_BLACK, 0};
 
     nMouseX = 0;
     nMouseY = 0;
@@ -52,14 +54,33 @@ private:
         Sprite.Create(nSpriteSize, nSpriteSize);
     }
 
-    if (MousePressed(BUTTON1_CLICKED, nMouseX, nMouseY)) {
+    // a press picks a color or paints, and a drag paints every cell between
+    // the positions it is reported at, which are only the latest per frame
+    cb::InputEvent event;
+
+    while (PollEvent(event)) {
+
+      if (EVENT_MOUSE != event.nType || !(event.nButtons & BUTTON1_PRESSED))
+        continue;
 
-      if (nMouseY == 0 && nMouseX > 0 && nMouseX < FG_COLORS) {
-        pixel.color = nMouseX;
+      if (event.nButtons & REPORT_MOUSE_POSITION) {
+
+        int nSteps = std::max(std::abs(event.x - nMouseX),
+                              std::abs(event.y - nMouseY));
+
+        for (int i = 1; i < nSteps; i++)
+          Paint(nMouseX + (event.x - nMouseX) * i / nSteps,
+                nMouseY + (event.y - nMouseY) * i / nSteps);
+      } else if (event.y == 0 && event.x > 0 && event.x < FG_COLORS) {
+        pixel.color = event.x;
         pixel.character = PIXEL_FULL;
-      } else if (nMouseY > 0 && nMouseY < (nSpriteSize + 1) && nMouseX > 0 &&
-                 nMouseX < (nSpriteSize + 1))
-        Sprite[(nMouseX - 1) + (nMouseY - 1) * nSpriteSize] = pixel;
+      }
+
+      nMouseX = event.x;
+
+      nMouseY = event.y;
+
+      Paint(nMouseX, nMouseY);
     }
 
     Clear(PIXEL_MEDIUM, FG_GREY);
@@ -75,11 +96,15 @@ private:
                L"(" + std::to_wstring(nMouseX - 1) + L", " +
                    std::to_wstring(nMouseY - 1) + L")");
 
-    usleep(23333);
-
     return true;
   }
 
+  void Paint(int x, int y) {
+
+    if (y > 0 && y < (nSpriteSize + 1) && x > 0 && x < (nSpriteSize + 1))
+      Sprite[(x - 1) + (y - 1) * nSpriteSize] = pixel;
+  }
+
   cb::Sprite Sprite;
   int nSpriteSize;
   cb::Pixel pixel;
@@ -0,0 +1,111 @@
+/**
+ *  @file   Sprites2Atlas.cpp
+ *  @brief  Pack Sprites into an Atlas
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "Atlas.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+int main(const int argc, const char *argv[]) {
+
+  int nArg = 2;
+
+  float fFrameTime = 0.1f;
+
+  if (argc > 3 && 0 == strcmp(argv[2], "-t")) {
+
+    fFrameTime = static_cast<float>(atof(argv[3]));
+
+    nArg = 4;
+  }
+
+  if (argc <= nArg) {
+
+    std::cerr << "usage: " << argv[0]
+              << " atlas [-t seconds] sprite [sprite ...]\n";
+    return 1;
+  }
+
+  std::vector<cb::Sprite> vSprites(argc - nArg);
+
+  std::vector<std::pair<std::string, const cb::Sprite *>> vNamed;
+
+  // sprites named as name_0, name_1, ... are the frames of animation name
+  std::map<std::string, std::map<int, std::string>> mAnimations;
+
+  std::set<std::string> sNames;
+
+  for (int i = nArg; i < argc; i++) {
+
+    if (!vSprites[i - nArg].Read(argv[i])) {
+
+      std::cerr << argv[i] << ": not a sprite\n";
+      return 2;
+    }
+
+    if (vSprites[i - nArg].SpriteWidth() * vSprites[i - nArg].SpriteHeight() <=
+        0) {
+
+      std::cerr << argv[i] << ": empty sprite\n";
+      return 2;
+    }
+
+    std::string name = std::filesystem::path(argv[i]).stem().string();
+
+    // a rect is found by the name of its sprite
+    if (!sNames.insert(name).second) {
+
+      std::cerr << argv[i] << ": another sprite is named " << name << "\n";
+      return 3;
+    }
+
+    vNamed.emplace_back(name, &vSprites[i - nArg]);
+
+    auto nSeparator = name.rfind('_');
+
+    if (std::string::npos != nSeparator && nSeparator + 1 < name.size() &&
+        std::string::npos ==
+            name.find_first_not_of("0123456789", nSeparator + 1))
+      mAnimations[name.substr(0, nSeparator)]
+                 [atoi(name.c_str() + nSeparator + 1)] = name;
+  }
+
+  cb::Atlas atlas;
+
+  if (!atlas.Pack(vNamed)) {
+
+    std::cerr << "no sheet could be made of the sprites\n";
+    return 3;
+  }
+
+  for (const auto &animation : mAnimations) {
+
+    std::vector<int> vFrames;
+
+    for (const auto &frame : animation.second)
+      vFrames.push_back(atlas.Find(frame.second));
+
+    atlas.AddAnimation(animation.first, vFrames, fFrameTime);
+  }
+
+  if (!atlas.Write(argv[1]))
+    return 4;
+
+  std::cout << atlas.Sheet().SpriteWidth() << "x"
+            << atlas.Sheet().SpriteHeight() << ", " << atlas.Rects()
+            << " sprites, " << atlas.Animations() << " animations\n";
+
+  return 0;
+}
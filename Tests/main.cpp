@@ -0,0 +1,359 @@
+/**
+ *  @file   main.cpp
+ *  @brief  Tests of the NCursesGameEngine output
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2021-07-30
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "../NCursesGameEngine.h"
+
+#include <clocale>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <sys/wait.h>
+#include <vector>
+
+#ifdef __APPLE__
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+typedef cb::NCursesGameEngine Engine;
+
+// plays the escape codes the engine writes back onto a screen of characters,
+// as a terminal would: cursor moves (CUP), repeats (REP) and erasing to the
+// end of the line (EL), while colors are skipped
+class Terminal {
+
+  int nWidth;
+
+  int nHeight;
+
+  int x = 0;
+
+  int y = 0;
+
+  wchar_t nLast = L' ';
+
+  std::vector<wchar_t> vScreen;
+
+  void Put(wchar_t character) {
+
+    if (x < nWidth && y < nHeight)
+      vScreen[x + y * nWidth] = character;
+
+    x++;
+
+    nLast = character;
+  }
+
+public:
+  Terminal(int nWidth, int nHeight)
+      : nWidth(nWidth), nHeight(nHeight), vScreen(nWidth * nHeight, L' ') {}
+
+  void Play(const std::string &sFrame) {
+
+    for (size_t i = 0; i < sFrame.size();) {
+
+      auto c = static_cast<unsigned char>(sFrame[i]);
+
+      if (0x1b == c && i + 1 < sFrame.size() && '[' == sFrame[i + 1]) {
+
+        size_t j = i + 2;
+
+        while (j < sFrame.size() && !isalpha(sFrame[j]))
+          j++;
+
+        std::string sParameters = sFrame.substr(i + 2, j - i - 2);
+
+        int n = atoi(sParameters.c_str());
+
+        switch (sFrame[j]) {
+        case 'H':
+          y = std::max(n, 1) - 1;
+          x = std::max(atoi(sParameters.c_str() + sParameters.find(';') + 1),
+                       1) -
+              1;
+          break;
+        case 'b':
+          while (n-- > 0)
+            Put(nLast);
+          break;
+        case 'K':
+          for (int k = x; k < nWidth && y < nHeight; k++)
+            vScreen[k + y * nWidth] = L' ';
+          break;
+        default:
+          break;
+        }
+
+        i = j + 1;
+
+        continue;
+      }
+
+      // UTF-8 of the Basic Multilingual Plane
+      wchar_t character = c;
+
+      int nBytes = 1;
+
+      if (0xE0 == (c & 0xF0)) {
+        character = ((c & 0x0F) << 12) | ((sFrame[i + 1] & 0x3F) << 6) |
+                    (sFrame[i + 2] & 0x3F);
+        nBytes = 3;
+      } else if (0xC0 == (c & 0xE0)) {
+        character = ((c & 0x1F) << 6) | (sFrame[i + 1] & 0x3F);
+        nBytes = 2;
+      }
+
+      Put(character);
+
+      i += nBytes;
+    }
+  }
+
+  [[nodiscard]] wchar_t At(int nX, int nY) const {
+    return vScreen[nX + nY * nWidth];
+  }
+};
+
+// draws a scene per frame and checks that the output of the frame before,
+// played on a terminal, shows what the engine presented
+class OutputTest : public cb::NCursesGameEngine {
+
+  std::vector<std::function<void(OutputTest &)>> vScenes;
+
+  Terminal terminal;
+
+  int nWidth;
+
+  int nHeight;
+
+public:
+  int nFailures = 0;
+
+  OutputTest(int nWidth, int nHeight,
+             std::vector<std::function<void(OutputTest &)>> vScenes)
+      : vScenes(std::move(vScenes)), terminal(nWidth, nHeight),
+        nWidth(nWidth), nHeight(nHeight) {}
+
+  bool OnUserCreate() override { return true; }
+
+  bool OnUserUpdate(float /* fElapsedTime */) override {
+
+    // nothing was presented before the first frame
+    if (FrameCount() > 0)
+      Check();
+
+    auto nFrame = static_cast<size_t>(FrameCount());
+
+    if (nFrame < vScenes.size())
+      vScenes[nFrame](*this);
+
+    return nFrame < vScenes.size();
+  }
+
+  void Check() {
+
+    terminal.Play(FrameOutput());
+
+    for (int y = 0; y < nHeight; y++)
+      for (int x = 0; x < nWidth; x++)
+        if (terminal.At(x, y) != PresentedCharacter(x, y)) {
+
+          printf("  frame %zu: (%d, %d) shows '%lc' instead of '%lc'\n",
+                 FrameCount(), x, y, static_cast<wint_t>(terminal.At(x, y)),
+                 static_cast<wint_t>(PresentedCharacter(x, y)));
+
+          nFailures++;
+
+          return;
+        }
+  }
+};
+
+static int Run(const char *pName, int nWidth, int nHeight,
+               std::vector<std::function<void(OutputTest &)>> vScenes) {
+
+  int nFailures = 0;
+
+  for (int nModes : {Engine::MODE_DEFAULT, Engine::MODE_TRUECOLOR}) {
+
+    OutputTest test(nWidth, nHeight, vScenes);
+
+    test.ConstructHeadless(nWidth, nHeight, nModes);
+
+    test.Start();
+
+    nFailures += test.nFailures;
+  }
+
+  printf("%s: %s\n", pName, nFailures ? "FAILED" : "ok");
+
+  return nFailures;
+}
+
+// draws a marker on the console for a few frames
+class ConsoleTest : public cb::NCursesGameEngine {
+
+public:
+  bool OnUserCreate() override { return true; }
+
+  bool OnUserUpdate(float /* fElapsedTime */) override {
+
+    Clear(L' ', FG_WHITE);
+
+    DrawString(2, 1, L"ncurses", FG_WHITE);
+
+    return true;
+  }
+};
+
+// runs ConsoleTest with the ncurses output on a pseudo terminal and checks
+// that the frames, and not only the setup, reach the terminal
+static int RunConsole(const char *pName) {
+
+  struct winsize sSize {};
+
+  sSize.ws_col = 80;
+
+  sSize.ws_row = 30;
+
+  int nMaster;
+
+  pid_t pid = forkpty(&nMaster, nullptr, nullptr, &sSize);
+
+  if (pid < 0) {
+
+    printf("%s: FAILED to open a pseudo terminal\n", pName);
+
+    return 1;
+  }
+
+  if (0 == pid) {
+
+    alarm(10);
+
+    setenv("TERM", "xterm-256color", 1);
+
+    {
+      ConsoleTest test;
+
+      test.ConstructConsole(Engine::OUTPUT_NCURSES);
+
+      test.SetFrameLimit(3);
+
+      test.Start();
+    }
+
+    _exit(0);
+  }
+
+  std::string sOutput;
+
+  char cBuffer[4096];
+
+  ssize_t n;
+
+  // the read fails with EIO once the child closed the terminal
+  while ((n = read(nMaster, cBuffer, sizeof(cBuffer))) > 0)
+    sOutput.append(cBuffer, n);
+
+  close(nMaster);
+
+  int nStatus = 0;
+
+  waitpid(pid, &nStatus, 0);
+
+  int nFailures = 0;
+
+  if (!WIFEXITED(nStatus) || 0 != WEXITSTATUS(nStatus)) {
+
+    printf("  the console test did not exit cleanly\n");
+
+    nFailures++;
+  }
+
+  if (std::string::npos == sOutput.find("ncurses")) {
+
+    printf("  the frame did not reach the terminal, only %zu bytes did\n",
+           sOutput.size());
+
+    nFailures++;
+  }
+
+  printf("%s: %s\n", pName, nFailures ? "FAILED" : "ok");
+
+  return nFailures;
+}
+
+int main() {
+
+  setlocale(LC_ALL, "");
+
+  int nFailures = 0;
+
+  // the blanks before the glyph do not reach the end of the line, so they
+  // must not be erased with EL, which leaves the cursor where it is
+  nFailures += Run("blanks then a glyph in the last column", 20, 2,
+                   {[](OutputTest &t) {
+                     t.Clear(L' ', Engine::FG_WHITE);
+
+                     t.DrawPixel(19, 0, L'X', Engine::FG_WHITE);
+                   }});
+
+  nFailures += Run("blanks to the end of the line", 20, 2,
+                   {[](OutputTest &t) { t.Clear(L'#', Engine::FG_WHITE); },
+                    [](OutputTest &t) {
+                      t.Clear(L' ', Engine::FG_WHITE);
+
+                      t.DrawString(0, 0, L"ab", Engine::FG_WHITE);
+                    }});
+
+  nFailures += Run("repeated glyphs around a change", 30, 3,
+                   {[](OutputTest &t) {
+                      t.Clear(L' ', Engine::FG_WHITE);
+
+                      t.DrawLine(0, 1, 29, 1, Engine::PIXEL_FULL,
+                                 Engine::FG_RED);
+                    },
+                    [](OutputTest &t) {
+                      t.DrawPixel(15, 1, L'o', Engine::FG_RED);
+
+                      t.DrawLine(3, 2, 29, 2, L'=', Engine::FG_BLUE);
+                    }});
+
+  std::vector<std::function<void(OutputTest &)>> vRandom;
+
+  srand(1);
+
+  for (int n = 0; n < 64; n++)
+    vRandom.emplace_back([](OutputTest &t) {
+      const wchar_t cGlyphs[] = {L' ', L' ', L'#', Engine::PIXEL_FULL};
+
+      for (int y = 0; y < t.ScreenHeight(); y++)
+        for (int x = 0; x < t.ScreenWidth();) {
+
+          int nRun = 1 + rand() % 12;
+
+          wchar_t character = cGlyphs[rand() % 4];
+
+          short color = static_cast<short>(Engine::FG_RED + rand() % 2);
+
+          for (; nRun > 0 && x < t.ScreenWidth(); nRun--, x++)
+            t.DrawPixel(x, y, character, color);
+        }
+    });
+
+  nFailures += Run("random runs", 40, 6, vRandom);
+
+  nFailures += RunConsole("ncurses output");
+
+  return nFailures ? 1 : 0;
+}
@@ -61,7 +61,7 @@ class Tetris : public cb::NCursesGameEngine {
 
   bool OnUserCreate() override {
 
-    srand(time(nullptr));
+    srand(RandomSeed());
 
     nField = new int[nFieldWidth * nFieldHeight];
 
@@ -87,8 +87,6 @@ class Tetris : public cb::NCursesGameEngine {
       Logic();
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-
     return !bFinished;
   }
 
@@ -317,7 +315,10 @@ class Tetris : public cb::NCursesGameEngine {
   }
 
 public:
-  Tetris() { bShowFPS = false; };
+  Tetris() {
+    bShowFPS = false;
+    SetTargetFPS(50.0f);
+  };
 };
 
 #endif // CBNCURSESGAMEENGINE_TETRIS_H